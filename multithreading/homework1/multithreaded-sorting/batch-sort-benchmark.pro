@@ -0,0 +1,29 @@
+TEMPLATE = app
+TARGET = batch-sort-benchmark
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+
+QMAKE_CXXFLAGS += -std=c++0x -pthread
+LIBS += -pthread
+
+SOURCES += src/batch_sort_benchmark.cpp \
+    src/thread_pool.cpp \
+    src/work_stealing_executor.cpp \
+    src/numa_topology.cpp \
+    src/data_generator.cpp \
+    src/range_sort.cpp \
+    src/simd_sort.cpp \
+    src/simd_sort_avx2.cpp \
+    src/simd_sort_sse4.cpp
+
+HEADERS += \
+    include/batch_sort.h \
+    include/thread_pool.h \
+    include/work_stealing_executor.h \
+    include/numa_topology.h \
+    include/data_generator.h \
+    include/array_arena.h \
+    include/range_sort.h \
+    include/simd_sort.h \
+    include/simd_sort_network.h
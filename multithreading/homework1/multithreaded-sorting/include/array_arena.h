@@ -0,0 +1,52 @@
+#ifndef ARRAY_ARENA_H
+#define ARRAY_ARENA_H
+
+#include <vector>
+#include <cstddef>
+
+// View of one array inside an arena.
+struct ArraySpan
+{
+    int* data;
+    std::size_t size;
+
+    int* begin() const { return data; }
+    int* end() const { return data + size; }
+};
+
+// One contiguous allocation holding a whole batch of arrays.
+// Every array starts on a cache line, the block itself is page aligned and
+// backed by huge pages when the system has them (explicit first, transparent otherwise).
+class ArrayArena
+{
+public:
+    ArrayArena();
+    ~ArrayArena();
+
+    ArrayArena(const ArrayArena&) = delete;
+    ArrayArena& operator=(const ArrayArena&) = delete;
+
+    // Previous arrays are dropped, the memory is reused when it is big enough.
+    // The memory is not touched here, so pages land where the arrays are first written.
+    void allocate(std::size_t arrays_number, std::size_t array_size);
+    void allocate(const std::vector<std::size_t>& sizes);
+
+    void release();
+
+    const std::vector<ArraySpan>& get_arrays() const { return arrays_; }
+    std::size_t get_capacity() const { return capacity_; }
+    bool is_huge_pages() const { return huge_pages_; }
+
+    static const std::size_t ALIGNMENT = 64;
+
+private:
+    void* memory_;
+    std::size_t capacity_;  // Bytes.
+    bool huge_pages_;
+
+    std::vector<ArraySpan> arrays_;
+
+    void reserve(std::size_t bytes);
+};
+
+#endif // ARRAY_ARENA_H
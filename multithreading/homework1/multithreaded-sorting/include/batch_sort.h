@@ -0,0 +1,281 @@
+#ifndef BATCH_SORT_H
+#define BATCH_SORT_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <limits>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/thread_pool.h"
+#include "include/work_stealing_executor.h"
+#include "include/range_sort.h"
+
+// Sorting of many independent arrays of any element type:
+//     sort_batch(arrays, compare, policy)
+// The policy says which threads do the work, the element type and comparator pick the algorithm
+// at compile time: arithmetic keys in ascending order go to LSD radix sort (int keys to range_sort),
+// everything else to std::sort with the given comparator.
+// The sorting templates are all here, but the pool policies and the int key path call compiled code:
+// link thread_pool.cpp, work_stealing_executor.cpp, numa_topology.cpp, range_sort.cpp and the simd_sort*.cpp files.
+
+template <typename T>
+struct BatchSpan
+{
+    T* data;
+    std::size_t size;
+
+    T* begin() const { return data; }
+    T* end() const { return data + size; }
+};
+
+// Every array on the calling thread, one after another.
+struct SequentialPolicy
+{
+};
+
+// One pool task per array.
+struct ThreadPoolPolicy
+{
+    ThreadPool& pool;
+
+    explicit ThreadPoolPolicy(ThreadPool& pool) : pool(pool) {}
+};
+
+// One task per array, arrays bigger than split_size are split around pivots so idle workers can steal the parts.
+struct WorkStealingPolicy
+{
+    WorkStealingExecutor& executor;
+    std::size_t split_size;
+
+    explicit WorkStealingPolicy(WorkStealingExecutor& executor, std::size_t split_size = 1 << 14) :
+        executor(executor),
+        split_size(split_size)
+    {
+    }
+};
+
+// Unsigned key with the same order as the value, for the radix passes.
+template <typename T, typename Enable = void>
+struct RadixKey;
+
+template <typename T>
+struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    typedef typename std::make_unsigned<T>::type type;
+
+    static type encode(T value)
+    {
+        // Flipping the sign bit makes signed order equal to unsigned order.
+        const type sign_bit = std::is_signed<T>::value ? type(1) << (sizeof(T) * 8 - 1) : 0;
+
+        return static_cast<type>(value) ^ sign_bit;
+    }
+};
+
+template <typename T>
+struct RadixKey<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    typedef typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type type;
+
+    static type encode(T value)
+    {
+        const type sign_bit = type(1) << (sizeof(T) * 8 - 1);
+
+        type bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        // Negative values: all bits flipped, so bigger magnitudes come first. Positive ones: above every negative.
+        return (bits & sign_bit) ? ~bits : bits | sign_bit;
+    }
+};
+
+// Keys sorted by their bit pattern instead of comparisons.
+template <typename T, typename Compare>
+struct IsRadixSortable : std::integral_constant<bool,
+        std::is_trivially_copyable<T>::value && std::is_arithmetic<T>::value && !std::is_same<T, bool>::value
+        && (sizeof(T) == 4 || sizeof(T) == 8) && std::is_same<Compare, std::less<T>>::value>
+{
+};
+
+// LSD radix sort with 8-bit digits, passes where all keys share the digit are skipped.
+template <typename T>
+void radix_sort_keys(T* data, std::size_t size)
+{
+    const unsigned int DIGIT_BITS = 8;
+    const unsigned int DIGITS = 1 << DIGIT_BITS;
+    const unsigned int PASSES = sizeof(T);
+
+    typedef RadixKey<T> Key;
+
+    if (size < 2)
+    {
+        return;
+    }
+
+    thread_local std::vector<T> buffer;
+
+    if (buffer.size() < size)
+    {
+        buffer.resize(size);
+    }
+
+    std::size_t counts[PASSES][DIGITS] = {};
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        typename Key::type key = Key::encode(data[i]);
+
+        for (unsigned int pass = 0; pass < PASSES; ++pass)
+        {
+            ++counts[pass][(key >> (pass * DIGIT_BITS)) & (DIGITS - 1)];
+        }
+    }
+
+    T* source = data;
+    T* destination = buffer.data();
+
+    for (unsigned int pass = 0; pass < PASSES; ++pass)
+    {
+        unsigned int shift = pass * DIGIT_BITS;
+        std::size_t* digit_counts = counts[pass];
+
+        if (digit_counts[(Key::encode(source[0]) >> shift) & (DIGITS - 1)] == size)
+        {
+            continue;
+        }
+
+        std::size_t offsets[DIGITS];
+        std::size_t offset = 0;
+
+        for (unsigned int digit = 0; digit < DIGITS; ++digit)
+        {
+            offsets[digit] = offset;
+            offset += digit_counts[digit];
+        }
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            destination[offsets[(Key::encode(source[i]) >> shift) & (DIGITS - 1)]++] = source[i];
+        }
+
+        std::swap(source, destination);
+    }
+
+    // Trivially copyable, so the odd pass count costs one memcpy.
+    if (source != data)
+    {
+        std::memcpy(data, source, size * sizeof(T));
+    }
+}
+
+template <typename T, typename Compare>
+void batch_sort_array(T* data, std::size_t size, Compare compare, std::false_type /* radix keys */)
+{
+    std::sort(data, data + size, compare);
+}
+
+template <typename T, typename Compare>
+void batch_sort_array(T* data, std::size_t size, Compare compare, std::true_type /* radix keys */)
+{
+    if (size < RADIX_SORT_MIN_SIZE)
+    {
+        std::sort(data, data + size, compare);
+    }
+    else
+    {
+        radix_sort_keys(data, size);
+    }
+}
+
+// Ascending int keys keep the tuned front-end: counting, radix or SIMD sort by the key range.
+inline void batch_sort_array(int* data, std::size_t size, std::less<int>, std::true_type /* radix keys */)
+{
+    range_sort(data, size);
+}
+
+template <typename T, typename Compare>
+void batch_sort_array(T* data, std::size_t size, Compare compare)
+{
+    batch_sort_array(data, size, compare, IsRadixSortable<T, Compare>());
+}
+
+template <typename T, typename Compare>
+void batch_sort_range(WorkStealingExecutor& executor, std::size_t split_size, T* first, T* last, Compare compare)
+{
+    // Three-way split, the keys may repeat a lot. The right part goes to this worker's deque.
+    while (static_cast<std::size_t>(last - first) > split_size)
+    {
+        const T& a = *first;
+        const T& b = first[(last - first) / 2];
+        const T& c = *(last - 1);
+
+        // Median of three, copied since partitioning moves the elements.
+        T pivot = compare(a, b) ? (compare(b, c) ? b : (compare(a, c) ? c : a))
+                                : (compare(a, c) ? a : (compare(b, c) ? c : b));
+
+        T* equal_first = std::partition(first, last, [&](const T& value) { return compare(value, pivot); });
+        T* equal_last = std::partition(equal_first, last, [&](const T& value) { return !compare(pivot, value); });
+
+        executor.submit([&executor, split_size, equal_last, last, compare]
+        {
+            batch_sort_range(executor, split_size, equal_last, last, compare);
+        });
+
+        last = equal_first;
+    }
+
+    batch_sort_array(first, last - first, compare);
+}
+
+template <typename T, typename Compare>
+void sort_batch_with(const std::vector<BatchSpan<T>>& arrays, Compare compare, const SequentialPolicy&)
+{
+    for (auto& arr : arrays)
+    {
+        batch_sort_array(arr.data, arr.size, compare);
+    }
+}
+
+template <typename T, typename Compare>
+void sort_batch_with(const std::vector<BatchSpan<T>>& arrays, Compare compare, const ThreadPoolPolicy& policy)
+{
+    for (auto& arr : arrays)
+    {
+        policy.pool.submit([arr, compare]
+        {
+            batch_sort_array(arr.data, arr.size, compare);
+        });
+    }
+
+    policy.pool.wait();
+}
+
+template <typename T, typename Compare>
+void sort_batch_with(const std::vector<BatchSpan<T>>& arrays, Compare compare, const WorkStealingPolicy& policy)
+{
+    WorkStealingExecutor& executor = policy.executor;
+    std::size_t split_size = std::max<std::size_t>(policy.split_size, 2);
+
+    for (auto& arr : arrays)
+    {
+        executor.submit([&executor, split_size, arr, compare]
+        {
+            batch_sort_range(executor, split_size, arr.begin(), arr.end(), compare);
+        });
+    }
+
+    executor.wait();
+}
+
+// Sort every array of the batch with compare. Returns when all of them are sorted.
+template <typename T, typename Compare = std::less<T>, typename Policy = SequentialPolicy>
+void sort_batch(const std::vector<BatchSpan<T>>& arrays, Compare compare = Compare(), Policy policy = Policy())
+{
+    sort_batch_with(arrays, compare, policy);
+}
+
+#endif // BATCH_SORT_H
@@ -0,0 +1,92 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/data_generator.h"
+#include "include/sort_modes.h"
+
+enum class ReportFormat
+{
+    text,
+    csv,
+    json
+};
+
+struct BenchmarkOptions
+{
+    std::size_t arrays_number;
+    std::size_t array_size;
+    bool uneven_sizes;  // Log-uniform sizes up to array_size instead of equal ones.
+
+    unsigned int threads_number;
+    std::vector<SortAlgorithm> algorithms;
+    Distribution distribution;
+
+    int min_value;
+    int max_value;
+    std::uint64_t seed;
+
+    unsigned int warmup_iterations;
+    unsigned int iterations;
+
+    ReportFormat format;
+    bool show_help;
+
+    bool affinity;     // Pin the sorting threads to cores.
+    bool numa;         // One pinned pool per NUMA node, each sorting the arrays first touched on its node.
+    bool numa_remote;  // Sort every node's arrays on the next node to measure the cross-node penalty.
+
+    // File mode: generate a test file and/or sort a file bigger than memory.
+    std::string generate_path;
+    std::size_t file_elements_number;
+    std::string external_input_path;
+    std::string output_path;
+    std::size_t memory_budget;  // Megabytes.
+
+    BenchmarkOptions();
+};
+
+struct BenchmarkResult
+{
+    SortAlgorithm algorithm;
+    unsigned int threads_number;
+    std::size_t elements_number;
+
+    // Sort phase only, microseconds.
+    long long min_duration;
+    long long median_duration;
+    long long p95_duration;
+
+    double throughput;  // Elements per second at the median duration.
+
+    // Medians over the measured iterations.
+    long long latency_p99;  // Microseconds until 99% of the arrays were sorted.
+    double utilization;     // Busy share of the sorting threads, 0..1.
+
+    // NUMA node of the sorting threads and of the sorted memory, -1 for the whole machine.
+    int node;
+    int memory_node;
+};
+
+// Prints the problem and returns false on bad arguments.
+bool parse_benchmark_options(int argc, char* argv[], BenchmarkOptions& options);
+void print_benchmark_usage(const char* program, std::ostream& out);
+
+// Warmup plus measured iterations of every selected algorithm, each one on freshly generated data.
+// Returns false if some algorithm produced a wrong result.
+bool run_benchmark(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results);
+
+// Generate and/or externally sort the files given in the options.
+bool run_file_benchmark(const BenchmarkOptions& options, std::ostream& out);
+
+void print_benchmark_results(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results,
+                             std::ostream& out);
+
+unsigned int get_cores_number();
+
+#endif // BENCHMARK_H
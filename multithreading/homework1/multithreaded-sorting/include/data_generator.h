@@ -0,0 +1,51 @@
+#ifndef DATA_GENERATOR_H
+#define DATA_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/array_arena.h"
+#include "include/thread_pool.h"
+
+enum class Distribution
+{
+    uniform,
+    sorted,
+    reverse,
+    few_unique,
+    zipf
+};
+
+const char* get_distribution_name(Distribution distribution);
+bool parse_distribution(const std::string& name, Distribution& distribution);
+
+// xoshiro256** generator, seeded through splitmix64.
+// Cheap and without shared state, so every worker owns one.
+class Xoshiro256
+{
+public:
+    explicit Xoshiro256(std::uint64_t seed);
+
+    std::uint64_t next();
+
+    // Uniform in [0, bound).
+    std::uint64_t next_below(std::uint64_t bound);
+
+    // Uniform in [0, 1).
+    double next_double();
+
+private:
+    std::uint64_t state_[4];
+};
+
+// Fill arrays with keys in [min_value, max_value] on the pool threads.
+// Arrays are cut into fixed slices and every slice has its own generator seeded from
+// (seed, array, slice), so the output only depends on the seed and not on the threads number.
+// first_array is the index of arrays[0] in the whole batch, when the batch is generated in parts.
+void generate_arrays(const std::vector<ArraySpan>& arrays, Distribution distribution,
+                     int min_value, int max_value, std::uint64_t seed, ThreadPool& pool,
+                     std::size_t first_array = 0);
+
+#endif // DATA_GENERATOR_H
@@ -0,0 +1,37 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/thread_pool.h"
+#include "include/data_generator.h"
+
+// Files hold native-endian 32-bit int records, nothing else.
+
+struct ExternalSortStats
+{
+    std::size_t elements_number;
+    std::size_t runs_number;
+
+    long long runs_duration;   // Microseconds to sort and spill the runs.
+    long long merge_duration;  // Microseconds of the k-way merge.
+};
+
+// Sort a file bigger than memory.
+// The memory-mapped input is cut into runs that fit in memory_budget bytes (the run plus the merge buffer),
+// each run is sorted by all pool threads and spilled next to the output file, then the runs are
+// streamed through a loser tree into the output with large sequential writes.
+// Prints the problem and returns false on I/O errors, leaving no partly written output file.
+bool external_sort(const std::string& input_path, const std::string& output_path, std::size_t memory_budget,
+                   ThreadPool& pool, ExternalSortStats& stats);
+
+// Check that output is sorted and holds the same keys as input.
+bool verify_sorted_file(const std::string& input_path, const std::string& output_path);
+
+// Write a reproducible test file, generated in chunks so it may be bigger than memory.
+bool generate_file(const std::string& path, std::size_t elements_number, Distribution distribution,
+                   int min_value, int max_value, std::uint64_t seed, ThreadPool& pool);
+
+#endif // EXTERNAL_SORT_H
@@ -0,0 +1,21 @@
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include <vector>
+
+struct NumaNode
+{
+    unsigned int id;
+    std::vector<unsigned int> cpus;  // Only CPUs this process may run on.
+};
+
+// Nodes from /sys/devices/system/node, one node with every allowed CPU when there is no NUMA.
+std::vector<NumaNode> get_numa_nodes();
+
+// Allowed CPUs, grouped node by node.
+std::vector<unsigned int> get_cpus_by_node();
+
+// Restrict the calling thread to the given CPUs, false if the system refused.
+bool pin_current_thread(const std::vector<unsigned int>& cpus);
+
+#endif // NUMA_TOPOLOGY_H
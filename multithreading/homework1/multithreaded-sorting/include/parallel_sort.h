@@ -0,0 +1,13 @@
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include <cstddef>
+
+#include "include/thread_pool.h"
+
+// Sort one big buffer on all pool threads.
+// Chunks are sorted in parallel, then merged pairwise in rounds.
+// Every merge is split along the merge path so each round keeps all threads busy.
+void parallel_merge_sort(int* data, std::size_t size, ThreadPool& pool);
+
+#endif // PARALLEL_SORT_H
@@ -0,0 +1,85 @@
+#ifndef RANGE_SORT_H
+#define RANGE_SORT_H
+
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+
+#include "include/simd_sort.h"
+
+// Sort front-end which picks the algorithm from the key range:
+// counting sort for narrow ranges, LSD radix sort for wide 32-bit keys,
+// comparison sort (simd_sort) when the array is too small for radix passes to pay off.
+
+enum class SortStrategy
+{
+    counting,
+    radix,
+    comparison
+};
+
+// Ranges up to this many distinct keys go to counting sort.
+const long long COUNTING_SORT_MAX_RANGE = 1 << 16;
+
+// Statically known ranges up to this size keep their counters on the stack.
+const long long COUNTING_SORT_MAX_STATIC_RANGE = 1 << 12;
+
+// Smaller arrays are cheaper to sort by comparison than with four radix passes.
+const std::size_t RADIX_SORT_MIN_SIZE = 1 << 12;
+
+const char* get_sort_strategy_name(SortStrategy strategy);
+
+// Runtime range: either given by the caller or found with one min/max pass.
+SortStrategy select_sort_strategy(std::size_t size, int min_key, int max_key);
+SortStrategy range_sort(int* data, std::size_t size, int min_key, int max_key);
+SortStrategy range_sort(int* data, std::size_t size);
+
+void counting_sort(int* data, std::size_t size, int min_key, int max_key);
+void radix_sort(int* data, std::size_t size);
+
+// Counting sort for keys in [MinKey, MaxKey] known at compile time.
+template <int MinKey, int MaxKey>
+void counting_sort(int* data, std::size_t size)
+{
+    static_assert(static_cast<long long>(MaxKey) - MinKey < COUNTING_SORT_MAX_STATIC_RANGE,
+                  "Range is too wide for stack counters.");
+
+    std::size_t counts[MaxKey - MinKey + 1] = {};
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        ++counts[data[i] - MinKey];
+    }
+
+    for (int key = MinKey; key <= MaxKey; ++key)
+    {
+        data = std::fill_n(data, counts[key - MinKey], key);
+    }
+}
+
+template <int MinKey, int MaxKey>
+SortStrategy range_sort_static(int* data, std::size_t size, std::true_type /* narrow */)
+{
+    counting_sort<MinKey, MaxKey>(data, size);
+
+    return SortStrategy::counting;
+}
+
+template <int MinKey, int MaxKey>
+SortStrategy range_sort_static(int* data, std::size_t size, std::false_type /* narrow */)
+{
+    return range_sort(data, size, MinKey, MaxKey);
+}
+
+// Range known at compile time, the narrow case is resolved without any runtime check.
+template <int MinKey, int MaxKey>
+SortStrategy range_sort(int* data, std::size_t size)
+{
+    static_assert(MinKey <= MaxKey, "Empty key range.");
+
+    typedef std::integral_constant<bool, static_cast<long long>(MaxKey) - MinKey < COUNTING_SORT_MAX_STATIC_RANGE> narrow;
+
+    return range_sort_static<MinKey, MaxKey>(data, size, narrow());
+}
+
+#endif // RANGE_SORT_H
@@ -0,0 +1,14 @@
+#ifndef SIMD_SORT_H
+#define SIMD_SORT_H
+
+#include <cstddef>
+
+// Sort a small int array with a vectorized sorting network followed by vectorized merges.
+// The AVX2 or SSE4.1 kernel is picked once at run time from the CPU features,
+// without them (and for big arrays) it is plain std::sort.
+void simd_sort(int* data, std::size_t size);
+
+// "avx2", "sse4.1" or "scalar".
+const char* get_simd_sort_kernel_name();
+
+#endif // SIMD_SORT_H
@@ -0,0 +1,124 @@
+#ifndef SIMD_SORT_NETWORK_H
+#define SIMD_SORT_NETWORK_H
+
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+
+// Register-width agnostic part of the SIMD sort.
+// Included by the per-instruction-set translation units after their target pragma,
+// so every instantiation is compiled for the instruction set of its Vector traits.
+//
+// Vector traits provide:
+//     Register, WIDTH,
+//     load(), store(),
+//     sort_columns(rows)  - sorting network across WIDTH registers, lane by lane,
+//     transpose(rows)     - WIDTH x WIDTH transpose,
+//     merge(low, high)    - bitonic merge of two sorted registers, low gets the smaller half.
+
+// Merge two sorted runs which sizes are multiples of WIDTH.
+template <typename Vector>
+inline void network_merge_runs(const int* a, std::size_t a_size, const int* b, std::size_t b_size, int* output)
+{
+    const unsigned int width = Vector::WIDTH;
+
+    typename Vector::Register low = Vector::load(a);
+    typename Vector::Register high = Vector::load(b);
+
+    std::size_t a_index = width;
+    std::size_t b_index = width;
+
+    for (;;)
+    {
+        Vector::merge(low, high);
+        Vector::store(output, low);
+        output += width;
+
+        // The next register comes from the run with the smaller head.
+        if (a_index < a_size && (b_index >= b_size || a[a_index] <= b[b_index]))
+        {
+            low = Vector::load(a + a_index);
+            a_index += width;
+        }
+        else if (b_index < b_size)
+        {
+            low = Vector::load(b + b_index);
+            b_index += width;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    Vector::store(output, high);
+}
+
+// buffer and scratch hold at least network_padded_size(size) elements.
+template <typename Vector>
+inline std::size_t network_padded_size(std::size_t size)
+{
+    const std::size_t block = Vector::WIDTH * Vector::WIDTH;
+
+    return (size + block - 1) / block * block;
+}
+
+template <typename Vector>
+inline void network_sort(int* data, std::size_t size, int* buffer, int* scratch)
+{
+    const unsigned int width = Vector::WIDTH;
+    const std::size_t block = width * width;
+    const std::size_t padded_size = network_padded_size<Vector>(size);
+
+    // Padding with the biggest key keeps the real keys in front.
+    std::copy(data, data + size, buffer);
+    std::fill(buffer + size, buffer + padded_size, std::numeric_limits<int>::max());
+
+    // Sort each block of WIDTH x WIDTH keys into WIDTH sorted runs of WIDTH keys.
+    for (std::size_t first = 0; first < padded_size; first += block)
+    {
+        typename Vector::Register rows[Vector::WIDTH];
+
+        for (unsigned int i = 0; i < width; ++i)
+        {
+            rows[i] = Vector::load(buffer + first + i * width);
+        }
+
+        Vector::sort_columns(rows);
+        Vector::transpose(rows);
+
+        for (unsigned int i = 0; i < width; ++i)
+        {
+            Vector::store(buffer + first + i * width, rows[i]);
+        }
+    }
+
+    // Bottom-up merge passes, ping-pong between the two buffers.
+    int* source = buffer;
+    int* destination = scratch;
+
+    for (std::size_t run = width; run < padded_size; run *= 2)
+    {
+        for (std::size_t first = 0; first < padded_size; first += 2 * run)
+        {
+            std::size_t middle = std::min(first + run, padded_size);
+            std::size_t last = std::min(first + 2 * run, padded_size);
+
+            if (middle == last)
+            {
+                std::copy(source + first, source + last, destination + first);
+            }
+            else
+            {
+                network_merge_runs<Vector>(source + first, middle - first, source + middle, last - middle,
+                                           destination + first);
+            }
+        }
+
+        std::swap(source, destination);
+    }
+
+    std::copy(source, source + size, data);
+}
+
+#endif // SIMD_SORT_NETWORK_H
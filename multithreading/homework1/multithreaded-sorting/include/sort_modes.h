@@ -0,0 +1,80 @@
+#ifndef SORT_MODES_H
+#define SORT_MODES_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "include/array_arena.h"
+#include "include/thread_pool.h"
+#include "include/work_stealing_executor.h"
+
+enum class SortAlgorithm
+{
+    std_sort,        // std::sort, one thread.
+    single_thread,   // simd_sort, one thread.
+    pthread,         // One pthread per array, gated by a semaphore.
+    thread_pool,     // One pool task per array.
+    work_stealing,   // Work-stealing executor, big arrays are split.
+    parallel_merge,  // Arrays one after another, each by all threads.
+    counting,        // Counting sort with the known key range, one thread.
+    radix,           // LSD radix sort, one thread.
+    range            // Strategy picked from the detected key range, one thread.
+};
+
+const char* get_sort_algorithm_name(SortAlgorithm algorithm);
+bool parse_sort_algorithm(const std::string& name, SortAlgorithm& algorithm);
+const std::vector<SortAlgorithm>& get_sort_algorithms();
+
+// Per-run bookkeeping of the sort modes: when every array was finished
+// and for how long the threads were busy sorting.
+class SortProgress
+{
+public:
+    SortProgress();
+
+    void start(const std::vector<ArraySpan>& arrays);
+
+    // The array is done when all of its elements were reported.
+    void mark_sorted(std::size_t array_index, std::size_t count);
+    void add_busy_time(std::chrono::high_resolution_clock::duration busy_time);
+
+    // Microseconds from start() until the given share (0..1) of the arrays was done.
+    long long get_latency(double percentile) const;
+
+    // Busy share of the threads over the run, 0..1.
+    double get_utilization(std::chrono::high_resolution_clock::duration duration, unsigned int threads_number) const;
+
+private:
+    std::chrono::high_resolution_clock::time_point start_;
+    std::unique_ptr<std::atomic<std::size_t>[]> unsorted_;
+    std::vector<std::chrono::high_resolution_clock::time_point> finish_;
+    std::atomic<long long> busy_time_;  // Nanoseconds.
+};
+
+// Threads and key range shared by the sort modes.
+struct SortContext
+{
+    ThreadPool& pool;
+    WorkStealingExecutor& executor;
+
+    int min_value;
+    int max_value;
+
+    // The pthread mode pins its i-th thread to cpus[i % cpus.size()], no pinning when empty.
+    std::vector<unsigned int> cpus;
+
+    SortProgress progress;
+
+    SortContext(ThreadPool& pool, WorkStealingExecutor& executor, int min_value, int max_value);
+};
+
+// Threads actually sorting in this mode.
+unsigned int get_sort_threads_number(SortAlgorithm algorithm, const SortContext& context);
+
+void sort_arrays(SortAlgorithm algorithm, const std::vector<ArraySpan>& arrays, SortContext& context);
+
+#endif // SORT_MODES_H
@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed-size pool of worker threads sharing one task queue.
+// Threads are started once and reused for every submitted task.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int threads_number);
+
+    // Worker i is pinned to cpus[i % cpus.size()], no pinning when cpus is empty.
+    ThreadPool(unsigned int threads_number, const std::vector<unsigned int>& cpus);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Block until every submitted task has finished.
+    void wait();
+
+    unsigned int get_threads_number() const { return static_cast<unsigned int>(workers_.size()); }
+
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    std::condition_variable tasks_finished_;
+
+    unsigned int pending_tasks_;  // Queued plus running.
+    bool stop_;
+
+    void start(unsigned int threads_number, const std::vector<unsigned int>& cpus);
+    void worker_loop(std::vector<unsigned int> cpus);
+};
+
+#endif // THREAD_POOL_H
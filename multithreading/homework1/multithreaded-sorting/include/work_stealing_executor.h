@@ -0,0 +1,63 @@
+#ifndef WORK_STEALING_EXECUTOR_H
+#define WORK_STEALING_EXECUTOR_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+// Executor with one task deque per worker.
+// A worker pushes and pops its own tasks at the back and steals from the front of
+// other workers' deques when its own deque runs dry, so uneven tasks even out at the tail.
+class WorkStealingExecutor
+{
+public:
+    explicit WorkStealingExecutor(unsigned int threads_number);
+
+    // Worker i is pinned to cpus[i % cpus.size()], no pinning when cpus is empty.
+    WorkStealingExecutor(unsigned int threads_number, const std::vector<unsigned int>& cpus);
+    ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    // Called from a worker the task goes to that worker's own deque,
+    // otherwise the deques are filled round-robin.
+    void submit(std::function<void()> task);
+
+    // Block until every submitted task (including tasks spawned by tasks) has finished.
+    void wait();
+
+    unsigned int get_threads_number() const { return static_cast<unsigned int>(workers_.size()); }
+    unsigned long long get_steals_number() const { return steals_number_; }
+
+private:
+    struct Worker
+    {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    std::condition_variable tasks_finished_;
+
+    std::atomic<unsigned int> queued_tasks_;
+    unsigned int pending_tasks_;  // Queued plus running, guarded by mutex_.
+    std::atomic<unsigned int> next_worker_;
+    std::atomic<unsigned long long> steals_number_;
+    bool stop_;
+
+    bool pop_task(unsigned int index, std::function<void()>& task);
+    void start(unsigned int threads_number, const std::vector<unsigned int>& cpus);
+    void worker_loop(unsigned int index, std::vector<unsigned int> cpus);
+};
+
+#endif // WORK_STEALING_EXECUTOR_H
@@ -6,4 +6,31 @@ CONFIG -= qt
 QMAKE_CXXFLAGS += -std=c++0x -pthread
 LIBS += -pthread
 
-SOURCES += src/main.cpp
+SOURCES += src/main.cpp \
+    src/thread_pool.cpp \
+    src/work_stealing_executor.cpp \
+    src/parallel_sort.cpp \
+    src/simd_sort.cpp \
+    src/simd_sort_avx2.cpp \
+    src/simd_sort_sse4.cpp \
+    src/range_sort.cpp \
+    src/array_arena.cpp \
+    src/data_generator.cpp \
+    src/sort_modes.cpp \
+    src/benchmark.cpp \
+    src/external_sort.cpp \
+    src/numa_topology.cpp
+
+HEADERS += \
+    include/thread_pool.h \
+    include/work_stealing_executor.h \
+    include/parallel_sort.h \
+    include/simd_sort.h \
+    include/simd_sort_network.h \
+    include/range_sort.h \
+    include/array_arena.h \
+    include/data_generator.h \
+    include/sort_modes.h \
+    include/benchmark.h \
+    include/external_sort.h \
+    include/numa_topology.h
@@ -0,0 +1,117 @@
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/mman.h>
+
+#include "include/array_arena.h"
+
+namespace
+{
+    const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    std::size_t round_up(std::size_t value, std::size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+ArrayArena::ArrayArena() :
+    memory_(nullptr),
+    capacity_(0),
+    huge_pages_(false)
+{
+}
+
+ArrayArena::~ArrayArena()
+{
+    release();
+}
+
+void ArrayArena::allocate(std::size_t arrays_number, std::size_t array_size)
+{
+    allocate(std::vector<std::size_t>(arrays_number, array_size));
+}
+
+void ArrayArena::allocate(const std::vector<std::size_t>& sizes)
+{
+    std::size_t bytes = 0;
+
+    for (auto size : sizes)
+    {
+        bytes += round_up(size * sizeof(int), ALIGNMENT);
+    }
+
+    reserve(bytes);
+
+    arrays_.clear();
+    arrays_.reserve(sizes.size());
+
+    char* position = static_cast<char*>(memory_);
+
+    for (auto size : sizes)
+    {
+        arrays_.push_back(ArraySpan { reinterpret_cast<int*>(position), size });
+        position += round_up(size * sizeof(int), ALIGNMENT);
+    }
+}
+
+void ArrayArena::release()
+{
+    if (memory_ != nullptr)
+    {
+        munmap(memory_, capacity_);
+    }
+
+    memory_ = nullptr;
+    capacity_ = 0;
+    huge_pages_ = false;
+    arrays_.clear();
+}
+
+void ArrayArena::reserve(std::size_t bytes)
+{
+    if (bytes <= capacity_ && memory_ != nullptr)
+    {
+        return;
+    }
+
+    release();
+
+    if (bytes == 0)
+    {
+        return;
+    }
+
+    // Explicit huge pages only exist when the administrator reserved them.
+    if (bytes >= HUGE_PAGE_SIZE)
+    {
+        std::size_t huge_bytes = round_up(bytes, HUGE_PAGE_SIZE);
+        void* memory = mmap(nullptr, huge_bytes, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (memory != MAP_FAILED)
+        {
+            memory_ = memory;
+            capacity_ = huge_bytes;
+            huge_pages_ = true;
+            return;
+        }
+    }
+
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+
+    memory_ = memory;
+    capacity_ = bytes;
+
+#ifdef MADV_HUGEPAGE
+    // Ask for transparent huge pages instead.
+    huge_pages_ = bytes >= HUGE_PAGE_SIZE && madvise(memory_, capacity_, MADV_HUGEPAGE) == 0;
+#endif
+}
@@ -0,0 +1,254 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/thread_pool.h"
+#include "include/work_stealing_executor.h"
+#include "include/data_generator.h"
+#include "include/batch_sort.h"
+
+// Throughput of sort_batch for every key type and policy, on uniform random keys.
+
+namespace
+{
+    struct Options
+    {
+        std::size_t arrays_number;
+        std::size_t array_size;
+        unsigned int threads_number;
+        unsigned int iterations;
+        std::uint64_t seed;
+    };
+
+    // Key-value record ordered by key only.
+    struct Record
+    {
+        std::uint64_t key;
+        std::uint64_t value;
+    };
+
+    struct RecordLess
+    {
+        bool operator()(const Record& a, const Record& b) const { return a.key < b.key; }
+    };
+
+    bool operator==(const Record& a, const Record& b)
+    {
+        return a.key == b.key && a.value == b.value;
+    }
+
+    template <typename T>
+    T make_key(Xoshiro256& generator);
+
+    template <>
+    int make_key<int>(Xoshiro256& generator)
+    {
+        return static_cast<int>(generator.next());
+    }
+
+    template <>
+    std::int64_t make_key<std::int64_t>(Xoshiro256& generator)
+    {
+        return static_cast<std::int64_t>(generator.next());
+    }
+
+    template <>
+    float make_key<float>(Xoshiro256& generator)
+    {
+        return static_cast<float>(generator.next_double() * 2e6 - 1e6);
+    }
+
+    template <>
+    double make_key<double>(Xoshiro256& generator)
+    {
+        return generator.next_double() * 2e6 - 1e6;
+    }
+
+    template <>
+    Record make_key<Record>(Xoshiro256& generator)
+    {
+        std::uint64_t key = generator.next();
+
+        return Record { key, ~key };
+    }
+
+    template <typename T>
+    void fill(std::vector<T>& storage, std::uint64_t seed)
+    {
+        Xoshiro256 generator(seed);
+
+        for (auto& value : storage)
+        {
+            value = make_key<T>(generator);
+        }
+    }
+
+    // Sorted by std::sort, arrays that lost, duplicated or changed elements differ from it.
+    template <typename T, typename Compare>
+    std::vector<T> get_reference(const Options& options, Compare compare)
+    {
+        std::vector<T> reference(options.arrays_number * options.array_size);
+        fill(reference, options.seed);
+
+        for (std::size_t i = 0; i < options.arrays_number; ++i)
+        {
+            auto first = reference.begin() + i * options.array_size;
+            std::sort(first, first + options.array_size, compare);
+        }
+
+        return reference;
+    }
+
+    // Median microseconds of the measured iterations, -1 on a wrong result.
+    template <typename T, typename Compare, typename Policy>
+    long long measure(const Options& options, Compare compare, Policy policy)
+    {
+        std::vector<T> storage(options.arrays_number * options.array_size);
+        std::vector<BatchSpan<T>> arrays;
+
+        for (std::size_t i = 0; i < options.arrays_number; ++i)
+        {
+            arrays.push_back(BatchSpan<T> { storage.data() + i * options.array_size, options.array_size });
+        }
+
+        std::vector<T> reference = get_reference<T>(options, compare);
+        std::vector<long long> durations;
+
+        // One untimed warmup run.
+        for (unsigned int iteration = 0; iteration <= options.iterations; ++iteration)
+        {
+            fill(storage, options.seed);
+
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            sort_batch(arrays, compare, policy);
+            std::chrono::high_resolution_clock::time_point finish = std::chrono::high_resolution_clock::now();
+
+            if (storage != reference)
+            {
+                return -1;
+            }
+
+            if (iteration > 0)
+            {
+                durations.push_back(std::chrono::duration_cast<std::chrono::microseconds> (finish - start).count());
+            }
+        }
+
+        std::nth_element(durations.begin(), durations.begin() + durations.size() / 2, durations.end());
+
+        return durations[durations.size() / 2];
+    }
+
+    template <typename T, typename Compare>
+    bool run(const char* type_name, const Options& options, Compare compare, ThreadPool& pool,
+             WorkStealingExecutor& executor)
+    {
+        long long durations[] =
+        {
+            measure<T>(options, compare, SequentialPolicy()),
+            measure<T>(options, compare, ThreadPoolPolicy(pool)),
+            measure<T>(options, compare, WorkStealingPolicy(executor))
+        };
+
+        const char* policy_names[] = { "sequential", "thread_pool", "work_stealing" };
+        bool verified = true;
+
+        std::cout << type_name << (IsRadixSortable<T, Compare>::value ? " (radix)" : " (comparison)") << ":" << std::endl;
+
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            if (durations[i] < 0)
+            {
+                std::cerr << "Wrong result of " << type_name << " " << policy_names[i] << "." << std::endl;
+                verified = false;
+                continue;
+            }
+
+            double throughput = options.arrays_number * options.array_size * 1e6 / std::max(1ll, durations[i]);
+
+            std::cout << "    " << policy_names[i] << ": " << durations[i] << " microseconds, "
+                      << throughput << " elements per second." << std::endl;
+        }
+
+        return verified;
+    }
+
+    bool parse_number(const char* text, unsigned long long& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            value = std::stoull(text, &parsed);
+
+            return text[parsed] == '\0' && text[0] != '-' && value > 0;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options { 1000, 10000, std::max(1u, std::thread::hardware_concurrency()), 5, 2017 };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        unsigned long long number = 0;
+
+        if (i + 1 == argc || !parse_number(argv[i + 1], number))
+        {
+            std::cerr << "Usage: " << argv[0] << " [--arrays N] [--size N] [--threads N] [--iterations N]" << std::endl;
+            return 1;
+        }
+
+        ++i;
+
+        if (option == "--arrays")
+        {
+            options.arrays_number = number;
+        }
+        else if (option == "--size")
+        {
+            options.array_size = number;
+        }
+        else if (option == "--threads")
+        {
+            options.threads_number = static_cast<unsigned int>(number);
+        }
+        else if (option == "--iterations")
+        {
+            options.iterations = static_cast<unsigned int>(number);
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+
+    ThreadPool pool(options.threads_number);
+    WorkStealingExecutor executor(options.threads_number);
+
+    std::cout << "Arrays: " << options.arrays_number << " x " << options.array_size << ", threads: "
+              << options.threads_number << ", median of " << options.iterations << " iterations." << std::endl;
+
+    bool verified = true;
+
+    verified = run<int>("int32", options, std::less<int>(), pool, executor) && verified;
+    verified = run<std::int64_t>("int64", options, std::less<std::int64_t>(), pool, executor) && verified;
+    verified = run<float>("float", options, std::less<float>(), pool, executor) && verified;
+    verified = run<double>("double", options, std::less<double>(), pool, executor) && verified;
+    verified = run<std::int64_t>("int64 descending", options, std::greater<std::int64_t>(), pool, executor) && verified;
+    verified = run<Record>("record", options, RecordLess(), pool, executor) && verified;
+
+    return verified ? 0 : 1;
+}
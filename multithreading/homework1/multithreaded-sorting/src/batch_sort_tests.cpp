@@ -0,0 +1,249 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/thread_pool.h"
+#include "include/work_stealing_executor.h"
+#include "include/data_generator.h"
+#include "include/batch_sort.h"
+
+// sort_batch of every policy and key type against std::sort of the same arrays.
+// Exits with 1 when any batch differs.
+
+namespace
+{
+    enum class Pattern
+    {
+        random,
+        few_unique,
+        sorted,
+        reverse
+    };
+
+    const Pattern PATTERNS[] = { Pattern::random, Pattern::few_unique, Pattern::sorted, Pattern::reverse };
+    const char* const PATTERN_NAMES[] = { "random", "few unique", "sorted", "reverse" };
+
+    // Empty and tiny arrays, both sides of the radix threshold and arrays the work-stealing policy splits.
+    const std::size_t ARRAY_SIZES[] = { 0, 1, 2, 3, 17, 100, 1000, RADIX_SORT_MIN_SIZE - 1, RADIX_SORT_MIN_SIZE,
+                                        5000, 40000 };
+
+    const unsigned int THREADS_NUMBER = 4;
+
+    struct Record
+    {
+        std::uint64_t key;
+        std::uint64_t value;
+    };
+
+    struct RecordLess
+    {
+        bool operator()(const Record& a, const Record& b) const { return a.key < b.key; }
+    };
+
+    bool operator==(const Record& a, const Record& b)
+    {
+        return a.key == b.key && a.value == b.value;
+    }
+
+    template <typename T>
+    T make_key(std::int64_t value)
+    {
+        return static_cast<T>(value);
+    }
+
+    template <>
+    float make_key<float>(std::int64_t value)
+    {
+        return static_cast<float>(value) / 1024;
+    }
+
+    template <>
+    double make_key<double>(std::int64_t value)
+    {
+        return static_cast<double>(value) / 1024;
+    }
+
+    // The value follows the key, so records std::sort may order either way are equal.
+    template <>
+    Record make_key<Record>(std::int64_t value)
+    {
+        return Record { static_cast<std::uint64_t>(value), static_cast<std::uint64_t>(value) * 31 };
+    }
+
+    template <>
+    std::string make_key<std::string>(std::int64_t value)
+    {
+        return std::to_string(value);
+    }
+
+    template <typename T>
+    void add_special_keys(std::vector<T>&)
+    {
+    }
+
+    // Signed zeros, infinities and denormals, which the radix key has to order like operator<.
+    template <typename T>
+    void add_floating_keys(std::vector<T>& storage)
+    {
+        const T special_keys[] = { T(-0.0), T(0.0), std::numeric_limits<T>::infinity(),
+                                   -std::numeric_limits<T>::infinity(), std::numeric_limits<T>::denorm_min(),
+                                   -std::numeric_limits<T>::denorm_min(), std::numeric_limits<T>::max(),
+                                   std::numeric_limits<T>::lowest() };
+
+        for (std::size_t i = 0; i < storage.size(); i += 97)
+        {
+            storage[i] = special_keys[i / 97 % (sizeof(special_keys) / sizeof(special_keys[0]))];
+        }
+    }
+
+    template <>
+    void add_special_keys<float>(std::vector<float>& storage)
+    {
+        add_floating_keys(storage);
+    }
+
+    template <>
+    void add_special_keys<double>(std::vector<double>& storage)
+    {
+        add_floating_keys(storage);
+    }
+
+    template <typename T>
+    std::vector<T> make_keys(Pattern pattern, std::size_t size, std::uint64_t seed)
+    {
+        Xoshiro256 generator(seed);
+        std::vector<T> storage;
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            std::int64_t half = static_cast<std::int64_t>(size / 2);
+            std::int64_t value = 0;
+
+            switch (pattern)
+            {
+            case Pattern::random:
+                value = static_cast<std::int64_t>(generator.next());
+                break;
+            case Pattern::few_unique:
+                value = static_cast<std::int64_t>(generator.next_below(7)) - 3;
+                break;
+            case Pattern::sorted:
+                value = static_cast<std::int64_t>(i) - half;
+                break;
+            case Pattern::reverse:
+                value = half - static_cast<std::int64_t>(i);
+                break;
+            }
+
+            storage.push_back(make_key<T>(value));
+        }
+
+        if (pattern == Pattern::random)
+        {
+            add_special_keys(storage);
+        }
+
+        return storage;
+    }
+
+    class Tester
+    {
+    public:
+        Tester() :
+            pool_(THREADS_NUMBER),
+            executor_(THREADS_NUMBER),
+            checks_number_(0),
+            failures_number_(0)
+        {
+        }
+
+        template <typename T, typename Compare>
+        void test(const char* type_name, Compare compare)
+        {
+            for (std::size_t pattern = 0; pattern < sizeof(PATTERNS) / sizeof(PATTERNS[0]); ++pattern)
+            {
+                std::string name = std::string(type_name) + ", " + PATTERN_NAMES[pattern];
+
+                check<T>(name + ", sequential", PATTERNS[pattern], compare, SequentialPolicy());
+                check<T>(name + ", thread pool", PATTERNS[pattern], compare, ThreadPoolPolicy(pool_));
+                check<T>(name + ", work stealing", PATTERNS[pattern], compare, WorkStealingPolicy(executor_));
+
+                // Small parts, so the arrays are split many times.
+                check<T>(name + ", work stealing split", PATTERNS[pattern], compare, WorkStealingPolicy(executor_, 64));
+            }
+        }
+
+        bool report() const
+        {
+            std::cout << checks_number_ - failures_number_ << " of " << checks_number_ << " batches sorted right."
+                      << std::endl;
+
+            return failures_number_ == 0;
+        }
+
+    private:
+        ThreadPool pool_;
+        WorkStealingExecutor executor_;
+
+        std::size_t checks_number_;
+        std::size_t failures_number_;
+
+        // One batch of arrays of every size, laid out one after another.
+        template <typename T, typename Compare, typename Policy>
+        void check(const std::string& name, Pattern pattern, Compare compare, Policy policy)
+        {
+            std::vector<T> storage;
+            std::vector<std::size_t> offsets;
+
+            for (std::size_t size : ARRAY_SIZES)
+            {
+                offsets.push_back(storage.size());
+
+                std::vector<T> keys = make_keys<T>(pattern, size, 2017 + size);
+                storage.insert(storage.end(), keys.begin(), keys.end());
+            }
+
+            std::vector<T> reference = storage;
+            std::vector<BatchSpan<T>> arrays;
+
+            for (std::size_t i = 0; i < offsets.size(); ++i)
+            {
+                std::sort(reference.begin() + offsets[i], reference.begin() + offsets[i] + ARRAY_SIZES[i], compare);
+                arrays.push_back(BatchSpan<T> { storage.data() + offsets[i], ARRAY_SIZES[i] });
+            }
+
+            sort_batch(arrays, compare, policy);
+
+            ++checks_number_;
+
+            if (storage != reference)
+            {
+                ++failures_number_;
+                std::cerr << "Wrong result: " << name << "." << std::endl;
+            }
+        }
+    };
+}
+
+int main()
+{
+    Tester tester;
+
+    tester.test<int>("int32", std::less<int>());
+    tester.test<std::uint32_t>("uint32", std::less<std::uint32_t>());
+    tester.test<std::int64_t>("int64", std::less<std::int64_t>());
+    tester.test<std::uint64_t>("uint64", std::less<std::uint64_t>());
+    tester.test<float>("float", std::less<float>());
+    tester.test<double>("double", std::less<double>());
+    tester.test<int>("int32 descending", std::greater<int>());
+    tester.test<std::int64_t>("int64 descending", std::greater<std::int64_t>());
+    tester.test<Record>("record", RecordLess());
+    tester.test<std::string>("string", std::less<std::string>());
+
+    return tester.report() ? 0 : 1;
+}
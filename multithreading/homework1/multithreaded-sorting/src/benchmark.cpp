@@ -0,0 +1,839 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/array_arena.h"
+#include "include/numa_topology.h"
+#include "include/thread_pool.h"
+#include "include/work_stealing_executor.h"
+#include "include/data_generator.h"
+#include "include/simd_sort.h"
+#include "include/sort_modes.h"
+#include "include/external_sort.h"
+#include "include/benchmark.h"
+
+namespace
+{
+    // Smallest array of an uneven batch.
+    const std::size_t UNEVEN_MIN_ARRAY_SIZE = 16;
+
+    const char* get_report_format_name(ReportFormat format)
+    {
+        switch (format)
+        {
+        case ReportFormat::text:
+            return "text";
+        case ReportFormat::csv:
+            return "csv";
+        case ReportFormat::json:
+            return "json";
+        }
+
+        return "unknown";
+    }
+
+    bool parse_report_format(const std::string& name, ReportFormat& format)
+    {
+        const ReportFormat formats[] = { ReportFormat::text, ReportFormat::csv, ReportFormat::json };
+
+        for (auto candidate : formats)
+        {
+            if (name == get_report_format_name(candidate))
+            {
+                format = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool parse_number(const std::string& text, unsigned long long& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            value = std::stoull(text, &parsed);
+
+            return parsed == text.size() && text[0] != '-';
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    bool parse_number(const std::string& text, int& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            value = std::stoi(text, &parsed);
+
+            return parsed == text.size();
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    std::vector<std::size_t> make_array_sizes(const BenchmarkOptions& options)
+    {
+        if (!options.uneven_sizes)
+        {
+            return std::vector<std::size_t>(options.arrays_number, options.array_size);
+        }
+
+        Xoshiro256 generator(options.seed);
+
+        std::size_t min_size = std::min(UNEVEN_MIN_ARRAY_SIZE, options.array_size);
+        double sizes_ratio = static_cast<double>(options.array_size) / std::max<std::size_t>(min_size, 1);
+
+        std::vector<std::size_t> sizes;
+        sizes.reserve(options.arrays_number);
+
+        for (std::size_t i = 0; i < options.arrays_number; ++i)
+        {
+            // Log-uniform size: lots of tiny arrays and a few huge ones.
+            sizes.push_back(static_cast<std::size_t>(min_size * std::pow(sizes_ratio, generator.next_double())));
+        }
+
+        return sizes;
+    }
+
+    // Order independent fingerprint of the keys, to catch lost or duplicated elements.
+    std::uint64_t get_checksum(const std::vector<ArraySpan>& arrays)
+    {
+        std::uint64_t checksum = 0;
+
+        for (auto& arr : arrays)
+        {
+            for (auto value : arr)
+            {
+                std::uint64_t key = static_cast<std::uint32_t>(value);
+                checksum += key * 0x9E3779B97F4A7C15ull ^ (key >> 7);
+            }
+        }
+
+        return checksum;
+    }
+
+    bool is_sorted(const std::vector<ArraySpan>& arrays)
+    {
+        for (auto& arr : arrays)
+        {
+            if (!std::is_sorted(arr.begin(), arr.end()))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    T get_percentile(std::vector<T> values, double percentile)
+    {
+        std::size_t index = std::min(values.size() - 1, static_cast<std::size_t>(percentile * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+
+        return values[index];
+    }
+
+    std::size_t get_elements_number(const std::vector<ArraySpan>& arrays)
+    {
+        std::size_t elements_number = 0;
+
+        for (auto& arr : arrays)
+        {
+            elements_number += arr.size;
+        }
+
+        return elements_number;
+    }
+
+    // Measured iterations of one algorithm on one group of threads.
+    struct Measurements
+    {
+        std::vector<long long> durations;
+        std::vector<long long> latencies;
+        std::vector<double> utilizations;
+    };
+
+    BenchmarkResult make_result(SortAlgorithm algorithm, unsigned int threads_number, std::size_t elements_number,
+                                const Measurements& measurements, int node, int memory_node)
+    {
+        BenchmarkResult result;
+        result.algorithm = algorithm;
+        result.threads_number = threads_number;
+        result.elements_number = elements_number;
+        result.min_duration = *std::min_element(measurements.durations.begin(), measurements.durations.end());
+        result.median_duration = get_percentile(measurements.durations, 0.5);
+        result.p95_duration = get_percentile(measurements.durations, 0.95);
+        result.throughput = elements_number * 1e6 / std::max(1ll, result.median_duration);
+        result.latency_p99 = get_percentile(measurements.latencies, 0.5);
+        result.utilization = get_percentile(measurements.utilizations, 0.5);
+        result.node = node;
+        result.memory_node = memory_node;
+
+        return result;
+    }
+
+    // Threads, pinned to one NUMA node, and the arrays first touched by them.
+    struct NodeGroup
+    {
+        NumaNode node;
+
+        std::unique_ptr<ThreadPool> pool;
+        std::unique_ptr<WorkStealingExecutor> executor;
+        std::unique_ptr<SortContext> context;
+
+        std::vector<ArraySpan> arrays;
+        std::size_t first_array;
+        std::size_t elements_number;
+    };
+
+    // Contiguous slices of about the same number of elements, one per node.
+    // Every slice is generated by its own node's threads, so first touch places its pages there.
+    std::vector<std::unique_ptr<NodeGroup>> make_node_groups(const BenchmarkOptions& options,
+                                                             const std::vector<ArraySpan>& arrays)
+    {
+        std::vector<NumaNode> nodes = get_numa_nodes();
+        nodes.resize(std::min(nodes.size(), arrays.size()));
+
+        std::size_t cpus_number = 0;
+
+        for (auto& node : nodes)
+        {
+            cpus_number += node.cpus.size();
+        }
+
+        std::size_t elements_number = get_elements_number(arrays);
+        std::size_t next_array = 0;
+        std::size_t assigned_elements = 0;
+
+        std::vector<std::unique_ptr<NodeGroup>> groups;
+
+        for (std::size_t k = 0; k < nodes.size(); ++k)
+        {
+            std::unique_ptr<NodeGroup> group(new NodeGroup());
+            group->node = nodes[k];
+
+            // Threads are shared out by the cores of every node.
+            unsigned int threads_number = std::max<unsigned int>(1,
+                    static_cast<unsigned int>(options.threads_number * group->node.cpus.size() / cpus_number));
+
+            group->pool.reset(new ThreadPool(threads_number, group->node.cpus));
+            group->executor.reset(new WorkStealingExecutor(threads_number, group->node.cpus));
+            group->context.reset(new SortContext(*group->pool, *group->executor, options.min_value, options.max_value));
+            group->context->cpus = group->node.cpus;
+
+            // Leave at least one array for every next node.
+            std::size_t slice_end = elements_number * (k + 1) / nodes.size();
+            std::size_t last_array = arrays.size() - (nodes.size() - k - 1);
+
+            group->first_array = next_array;
+
+            while (next_array < last_array && (next_array == group->first_array || assigned_elements < slice_end))
+            {
+                assigned_elements += arrays[next_array].size;
+                group->arrays.push_back(arrays[next_array++]);
+            }
+
+            group->elements_number = get_elements_number(group->arrays);
+            groups.push_back(std::move(group));
+        }
+
+        return groups;
+    }
+
+    bool run_numa_benchmark(const BenchmarkOptions& options, ArrayArena& arena, std::vector<BenchmarkResult>& results)
+    {
+        std::vector<std::unique_ptr<NodeGroup>> groups = make_node_groups(options, arena.get_arrays());
+        std::size_t elements_number = get_elements_number(arena.get_arrays());
+
+        bool verified = true;
+
+        for (auto algorithm : options.algorithms)
+        {
+            std::vector<Measurements> node_measurements(groups.size());
+            Measurements total_measurements;
+
+            std::vector<unsigned int> threads_numbers;
+            unsigned int total_threads_number = 0;
+
+            for (auto& group : groups)
+            {
+                threads_numbers.push_back(get_sort_threads_number(algorithm, *group->context));
+                total_threads_number += threads_numbers.back();
+            }
+
+            for (unsigned int iteration = 0; iteration < options.warmup_iterations + options.iterations; ++iteration)
+            {
+                std::vector<std::uint64_t> checksums;
+
+                for (auto& group : groups)
+                {
+                    generate_arrays(group->arrays, options.distribution, options.min_value, options.max_value,
+                                    options.seed, *group->pool, group->first_array);
+                    checksums.push_back(get_checksum(group->arrays));
+                }
+
+                std::vector<std::chrono::high_resolution_clock::duration> durations(groups.size());
+                std::vector<std::thread> drivers;
+
+                std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+                for (std::size_t k = 0; k < groups.size(); ++k)
+                {
+                    // Data of node k is sorted by node k, or by the next node in the remote mode.
+                    NodeGroup* sorter = groups[(k + (options.numa_remote ? 1 : 0)) % groups.size()].get();
+                    NodeGroup* data = groups[k].get();
+                    std::chrono::high_resolution_clock::duration* duration = &durations[k];
+
+                    drivers.push_back(std::thread([=]
+                    {
+                        // The one-thread modes sort on the driver itself.
+                        pin_current_thread(sorter->node.cpus);
+
+                        std::chrono::high_resolution_clock::time_point node_start =
+                                std::chrono::high_resolution_clock::now();
+                        sort_arrays(algorithm, data->arrays, *sorter->context);
+                        *duration = std::chrono::high_resolution_clock::now() - node_start;
+                    }));
+                }
+
+                for (auto& driver : drivers)
+                {
+                    driver.join();
+                }
+
+                std::chrono::high_resolution_clock::time_point finish = std::chrono::high_resolution_clock::now();
+
+                bool iteration_verified = true;
+
+                for (std::size_t k = 0; k < groups.size(); ++k)
+                {
+                    iteration_verified = iteration_verified && is_sorted(groups[k]->arrays)
+                            && get_checksum(groups[k]->arrays) == checksums[k];
+                }
+
+                if (!iteration_verified)
+                {
+                    std::cerr << "Wrong result of " << get_sort_algorithm_name(algorithm) << "." << std::endl;
+                    verified = false;
+                    break;
+                }
+
+                if (iteration < options.warmup_iterations)
+                {
+                    continue;
+                }
+
+                long long latency = 0;
+                double busy_threads = 0.0;
+
+                for (std::size_t k = 0; k < groups.size(); ++k)
+                {
+                    std::size_t sorter_index = (k + (options.numa_remote ? 1 : 0)) % groups.size();
+                    SortProgress& progress = groups[sorter_index]->context->progress;
+
+                    Measurements& measurements = node_measurements[k];
+                    measurements.durations.push_back(
+                            std::chrono::duration_cast<std::chrono::microseconds> (durations[k]).count());
+                    measurements.latencies.push_back(progress.get_latency(0.99));
+                    measurements.utilizations.push_back(
+                            progress.get_utilization(durations[k], threads_numbers[sorter_index]));
+
+                    latency = std::max(latency, measurements.latencies.back());
+                    busy_threads += progress.get_utilization(finish - start, threads_numbers[sorter_index])
+                            * threads_numbers[sorter_index];
+                }
+
+                total_measurements.durations.push_back(
+                        std::chrono::duration_cast<std::chrono::microseconds> (finish - start).count());
+                total_measurements.latencies.push_back(latency);
+                total_measurements.utilizations.push_back(busy_threads / std::max(1u, total_threads_number));
+            }
+
+            if (total_measurements.durations.empty())
+            {
+                continue;
+            }
+
+            for (std::size_t k = 0; k < groups.size(); ++k)
+            {
+                std::size_t sorter_index = (k + (options.numa_remote ? 1 : 0)) % groups.size();
+
+                results.push_back(make_result(algorithm, threads_numbers[sorter_index], groups[k]->elements_number,
+                                              node_measurements[k], groups[sorter_index]->node.id,
+                                              groups[k]->node.id));
+            }
+
+            results.push_back(make_result(algorithm, total_threads_number, elements_number, total_measurements, -1, -1));
+        }
+
+        return verified;
+    }
+}
+
+BenchmarkOptions::BenchmarkOptions() :
+    arrays_number(1000),
+    array_size(1000),
+    uneven_sizes(false),
+    threads_number(get_cores_number()),
+    algorithms(get_sort_algorithms()),
+    distribution(Distribution::uniform),
+    min_value(1),
+    max_value(100),
+    seed(2017),
+    warmup_iterations(2),
+    iterations(10),
+    format(ReportFormat::text),
+    show_help(false),
+    affinity(false),
+    numa(false),
+    numa_remote(false),
+    file_elements_number(256 * 1024 * 1024),
+    memory_budget(256)
+{
+}
+
+bool parse_benchmark_options(int argc, char* argv[], BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+
+        if (option == "--help")
+        {
+            options.show_help = true;
+            continue;
+        }
+
+        if (option == "--uneven")
+        {
+            options.uneven_sizes = true;
+            continue;
+        }
+
+        if (option == "--affinity")
+        {
+            options.affinity = true;
+            continue;
+        }
+
+        if (option == "--numa" || option == "--numa-remote")
+        {
+            options.numa = true;
+            options.numa_remote = option == "--numa-remote";
+            continue;
+        }
+
+        const char* value_options[] = { "--arrays", "--size", "--threads", "--algorithm", "--distribution",
+                                        "--min-value", "--max-value", "--seed", "--warmup", "--iterations", "--format",
+                                        "--generate-file", "--elements", "--external-sort", "--output",
+                                        "--memory-budget" };
+
+        if (std::find(std::begin(value_options), std::end(value_options), option) == std::end(value_options))
+        {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return false;
+        }
+
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value of option: " << option << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+        unsigned long long number = 0;
+        bool valid = true;
+
+        if (option == "--arrays")
+        {
+            valid = parse_number(value, number) && number > 0;
+            options.arrays_number = number;
+        }
+        else if (option == "--size")
+        {
+            valid = parse_number(value, number) && number > 0;
+            options.array_size = number;
+        }
+        else if (option == "--threads")
+        {
+            valid = parse_number(value, number) && number > 0;
+            options.threads_number = static_cast<unsigned int>(number);
+        }
+        else if (option == "--algorithm")
+        {
+            SortAlgorithm algorithm;
+
+            if (value == "all")
+            {
+                options.algorithms = get_sort_algorithms();
+            }
+            else if ((valid = parse_sort_algorithm(value, algorithm)))
+            {
+                options.algorithms.assign(1, algorithm);
+            }
+        }
+        else if (option == "--distribution")
+        {
+            valid = parse_distribution(value, options.distribution);
+        }
+        else if (option == "--min-value")
+        {
+            valid = parse_number(value, options.min_value);
+        }
+        else if (option == "--max-value")
+        {
+            valid = parse_number(value, options.max_value);
+        }
+        else if (option == "--seed")
+        {
+            valid = parse_number(value, number);
+            options.seed = number;
+        }
+        else if (option == "--warmup")
+        {
+            valid = parse_number(value, number);
+            options.warmup_iterations = static_cast<unsigned int>(number);
+        }
+        else if (option == "--iterations")
+        {
+            valid = parse_number(value, number) && number > 0;
+            options.iterations = static_cast<unsigned int>(number);
+        }
+        else if (option == "--format")
+        {
+            valid = parse_report_format(value, options.format);
+        }
+        else if (option == "--generate-file")
+        {
+            options.generate_path = value;
+        }
+        else if (option == "--elements")
+        {
+            valid = parse_number(value, number);
+            options.file_elements_number = number;
+        }
+        else if (option == "--external-sort")
+        {
+            options.external_input_path = value;
+        }
+        else if (option == "--output")
+        {
+            options.output_path = value;
+        }
+        else if (option == "--memory-budget")
+        {
+            valid = parse_number(value, number) && number > 0;
+            options.memory_budget = number;
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Invalid value of option " << option << ": " << value << std::endl;
+            return false;
+        }
+    }
+
+    if (!options.external_input_path.empty() && options.output_path.empty())
+    {
+        std::cerr << "Missing --output of --external-sort." << std::endl;
+        return false;
+    }
+
+    if (options.min_value > options.max_value)
+    {
+        std::cerr << "Invalid key range: " << options.min_value << ".." << options.max_value << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void print_benchmark_usage(const char* program, std::ostream& out)
+{
+    out << "Usage: " << program << " [options]" << std::endl
+        << "  --arrays N           number of arrays (1000)" << std::endl
+        << "  --size N             elements per array, the biggest one with --uneven (1000)" << std::endl
+        << "  --uneven             log-uniform array sizes" << std::endl
+        << "  --threads N          sorting threads (cores number)" << std::endl
+        << "  --algorithm NAME     all";
+
+    for (auto algorithm : get_sort_algorithms())
+    {
+        out << ", " << get_sort_algorithm_name(algorithm);
+    }
+
+    out << " (all)" << std::endl
+        << "  --distribution NAME  uniform, sorted, reverse, few_unique, zipf (uniform)" << std::endl
+        << "  --min-value N        smallest key (1)" << std::endl
+        << "  --max-value N        biggest key (100)" << std::endl
+        << "  --seed N             data generator seed (2017)" << std::endl
+        << "  --warmup N           iterations before measuring (2)" << std::endl
+        << "  --iterations N       measured iterations (10)" << std::endl
+        << "  --format NAME        text, csv, json (text)" << std::endl
+        << "  --affinity           pin the sorting threads to cores" << std::endl
+        << "  --numa               per NUMA node pinned threads sorting node-local arrays, per node throughput" << std::endl
+        << "  --numa-remote        like --numa, but every node sorts the arrays of the next node" << std::endl
+        << "File mode:" << std::endl
+        << "  --generate-file PATH write a test file of int keys (--distribution, --seed, key range)" << std::endl
+        << "  --elements N         keys in the generated file (268435456)" << std::endl
+        << "  --external-sort PATH sort a file of int keys bigger than memory" << std::endl
+        << "  --output PATH        sorted file" << std::endl
+        << "  --memory-budget MB   memory for the sorted runs (256)" << std::endl;
+}
+
+bool run_benchmark(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+    // Not touched by the allocation, pages land on the node of the thread generating the data.
+    ArrayArena arena;
+    arena.allocate(make_array_sizes(options));
+
+    if (options.numa)
+    {
+        return run_numa_benchmark(options, arena, results);
+    }
+
+    std::vector<unsigned int> cpus;
+
+    if (options.affinity)
+    {
+        cpus = get_cpus_by_node();
+    }
+
+    // Started once and reused by every run.
+    ThreadPool pool(options.threads_number, cpus);
+    WorkStealingExecutor executor(options.threads_number, cpus);
+
+    SortContext context(pool, executor, options.min_value, options.max_value);
+    context.cpus = cpus;
+
+    const std::vector<ArraySpan>& arrays = arena.get_arrays();
+    std::size_t elements_number = get_elements_number(arrays);
+
+    bool verified = true;
+
+    for (auto algorithm : options.algorithms)
+    {
+        Measurements measurements;
+
+        unsigned int threads_number = get_sort_threads_number(algorithm, context);
+
+        for (unsigned int iteration = 0; iteration < options.warmup_iterations + options.iterations; ++iteration)
+        {
+            // Same input for every iteration and algorithm, generation is not timed.
+            generate_arrays(arrays, options.distribution, options.min_value, options.max_value, options.seed, pool);
+            std::uint64_t checksum = get_checksum(arrays);
+
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            sort_arrays(algorithm, arrays, context);
+            std::chrono::high_resolution_clock::time_point finish = std::chrono::high_resolution_clock::now();
+
+            if (!is_sorted(arrays) || get_checksum(arrays) != checksum)
+            {
+                std::cerr << "Wrong result of " << get_sort_algorithm_name(algorithm) << "." << std::endl;
+                verified = false;
+                break;
+            }
+
+            if (iteration >= options.warmup_iterations)
+            {
+                measurements.durations.push_back(
+                        std::chrono::duration_cast<std::chrono::microseconds> (finish - start).count());
+                measurements.latencies.push_back(context.progress.get_latency(0.99));
+                measurements.utilizations.push_back(context.progress.get_utilization(finish - start, threads_number));
+            }
+        }
+
+        if (measurements.durations.empty())
+        {
+            continue;
+        }
+
+        results.push_back(make_result(algorithm, threads_number, elements_number, measurements, -1, -1));
+    }
+
+    return verified;
+}
+
+bool run_file_benchmark(const BenchmarkOptions& options, std::ostream& out)
+{
+    ThreadPool pool(options.threads_number);
+
+    if (!options.generate_path.empty())
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+        if (!generate_file(options.generate_path, options.file_elements_number, options.distribution,
+                           options.min_value, options.max_value, options.seed, pool))
+        {
+            return false;
+        }
+
+        std::chrono::high_resolution_clock::time_point finish = std::chrono::high_resolution_clock::now();
+
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds> (finish - start).count();
+        out << "Generated " << options.file_elements_number << " keys to " << options.generate_path
+            << " in " << duration << " microseconds." << std::endl;
+    }
+
+    if (options.external_input_path.empty())
+    {
+        return true;
+    }
+
+    ExternalSortStats stats;
+
+    if (!external_sort(options.external_input_path, options.output_path, options.memory_budget * 1024 * 1024,
+                       pool, stats))
+    {
+        return false;
+    }
+
+    if (!verify_sorted_file(options.external_input_path, options.output_path))
+    {
+        return false;
+    }
+
+    long long duration = stats.runs_duration + stats.merge_duration;
+    double throughput = stats.elements_number * 1e6 / std::max(1ll, duration);
+
+    switch (options.format)
+    {
+    case ReportFormat::text:
+        out << "External sort of " << stats.elements_number << " keys in " << stats.runs_number << " runs ("
+            << options.memory_budget << " MB budget, threads: " << pool.get_threads_number() << ")." << std::endl;
+        out << "    Runs: " << stats.runs_duration << " microseconds, merge: " << stats.merge_duration
+            << " microseconds, " << throughput << " elements per second." << std::endl;
+        break;
+
+    case ReportFormat::csv:
+        out << "elements,runs,memory_budget_mb,threads,runs_us,merge_us,elements_per_second" << std::endl;
+        out << stats.elements_number << "," << stats.runs_number << "," << options.memory_budget << ","
+            << pool.get_threads_number() << "," << stats.runs_duration << "," << stats.merge_duration << ","
+            << throughput << std::endl;
+        break;
+
+    case ReportFormat::json:
+        out << "{ \"elements\": " << stats.elements_number
+            << ", \"runs\": " << stats.runs_number
+            << ", \"memory_budget_mb\": " << options.memory_budget
+            << ", \"threads\": " << pool.get_threads_number()
+            << ", \"runs_us\": " << stats.runs_duration
+            << ", \"merge_us\": " << stats.merge_duration
+            << ", \"elements_per_second\": " << throughput << " }" << std::endl;
+        break;
+    }
+
+    return true;
+}
+
+void print_benchmark_results(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results,
+                             std::ostream& out)
+{
+    switch (options.format)
+    {
+    case ReportFormat::text:
+        out << "Sort kernel: " << get_simd_sort_kernel_name() << "." << std::endl;
+        out << "Arrays: " << options.arrays_number << " x " << options.array_size
+            << (options.uneven_sizes ? " (uneven)" : "") << ", " << get_distribution_name(options.distribution)
+            << " keys " << options.min_value << ".." << options.max_value << "." << std::endl;
+        out << "Iterations: " << options.iterations << " (+" << options.warmup_iterations << " warmup)."
+            << std::endl;
+
+        if (options.numa)
+        {
+            out << "NUMA nodes: " << get_numa_nodes().size() << ", "
+                << (options.numa_remote ? "remote" : "local") << " memory." << std::endl;
+        }
+        else if (options.affinity)
+        {
+            out << "Threads pinned to cores." << std::endl;
+        }
+
+        out << std::endl;
+
+        for (auto& result : results)
+        {
+            if (result.node >= 0)
+            {
+                out << "[node " << result.node << ", memory on node " << result.memory_node << "] ";
+            }
+
+            out << get_sort_algorithm_name(result.algorithm) << " (threads: " << result.threads_number << ")"
+                << " min/median/p95: " << result.min_duration << "/" << result.median_duration << "/"
+                << result.p95_duration << " microseconds, " << result.throughput << " elements per second." << std::endl;
+            out << "    Array latency p99: " << result.latency_p99 << " microseconds, core utilization: "
+                << result.utilization * 100.0 << "%." << std::endl;
+        }
+        break;
+
+    case ReportFormat::csv:
+        out << "algorithm,distribution,arrays,array_size,uneven,threads,iterations,"
+               "min_us,median_us,p95_us,elements_per_second,latency_p99_us,utilization,node,memory_node" << std::endl;
+
+        for (auto& result : results)
+        {
+            out << get_sort_algorithm_name(result.algorithm) << "," << get_distribution_name(options.distribution)
+                << "," << options.arrays_number << "," << options.array_size << "," << options.uneven_sizes
+                << "," << result.threads_number << "," << options.iterations << "," << result.min_duration
+                << "," << result.median_duration << "," << result.p95_duration << "," << result.throughput
+                << "," << result.latency_p99 << "," << result.utilization << "," << result.node
+                << "," << result.memory_node << std::endl;
+        }
+        break;
+
+    case ReportFormat::json:
+        out << "{" << std::endl
+            << "  \"kernel\": \"" << get_simd_sort_kernel_name() << "\"," << std::endl
+            << "  \"distribution\": \"" << get_distribution_name(options.distribution) << "\"," << std::endl
+            << "  \"arrays\": " << options.arrays_number << "," << std::endl
+            << "  \"array_size\": " << options.array_size << "," << std::endl
+            << "  \"uneven\": " << (options.uneven_sizes ? "true" : "false") << "," << std::endl
+            << "  \"iterations\": " << options.iterations << "," << std::endl
+            << "  \"affinity\": " << (options.affinity || options.numa ? "true" : "false") << "," << std::endl
+            << "  \"numa\": \"" << (options.numa ? (options.numa_remote ? "remote" : "local") : "off") << "\","
+            << std::endl
+            << "  \"results\": [" << std::endl;
+
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchmarkResult& result = results[i];
+
+            out << "    { \"algorithm\": \"" << get_sort_algorithm_name(result.algorithm) << "\""
+                << ", \"threads\": " << result.threads_number
+                << ", \"min_us\": " << result.min_duration
+                << ", \"median_us\": " << result.median_duration
+                << ", \"p95_us\": " << result.p95_duration
+                << ", \"elements_per_second\": " << result.throughput
+                << ", \"latency_p99_us\": " << result.latency_p99
+                << ", \"utilization\": " << result.utilization
+                << ", \"node\": " << result.node
+                << ", \"memory_node\": " << result.memory_node << " }"
+                << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+
+        out << "  ]" << std::endl << "}" << std::endl;
+        break;
+    }
+}
+
+unsigned int get_cores_number()
+{
+    return std::thread::hardware_concurrency();
+}
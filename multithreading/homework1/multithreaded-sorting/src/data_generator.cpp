@@ -0,0 +1,240 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/array_arena.h"
+#include "include/thread_pool.h"
+#include "include/data_generator.h"
+
+namespace
+{
+    // Elements generated by one task (and by one generator).
+    const std::size_t SLICE_SIZE = 1 << 16;
+
+    // Distinct keys of the few_unique distribution.
+    const std::uint64_t FEW_UNIQUE_KEYS = 8;
+
+    std::uint64_t splitmix64(std::uint64_t& state)
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+        return z ^ (z >> 31);
+    }
+
+    std::uint64_t rotate_left(std::uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    std::uint64_t slice_seed(std::uint64_t seed, std::size_t array_index, std::size_t slice_index)
+    {
+        std::uint64_t state = seed;
+        state ^= splitmix64(state) + array_index;
+        state ^= splitmix64(state) + slice_index;
+
+        return splitmix64(state);
+    }
+
+    // Slice [first, last) of an array of the given size.
+    void generate_slice(int* data, std::size_t first, std::size_t last, std::size_t size,
+                        Distribution distribution, int min_value, int max_value, std::uint64_t seed)
+    {
+        const std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(max_value) - min_value) + 1;
+
+        Xoshiro256 generator(seed);
+
+        switch (distribution)
+        {
+        case Distribution::uniform:
+            for (std::size_t i = first; i < last; ++i)
+            {
+                data[i] = static_cast<int>(min_value + static_cast<std::int64_t>(generator.next_below(range)));
+            }
+            break;
+
+        case Distribution::sorted:
+        case Distribution::reverse:
+            // A ramp over the whole range, computable for any slice independently.
+            for (std::size_t i = first; i < last; ++i)
+            {
+                std::size_t position = distribution == Distribution::sorted ? i : size - 1 - i;
+                std::uint64_t offset = static_cast<std::uint64_t>(
+                            static_cast<unsigned __int128>(position) * range / size);
+
+                data[i] = static_cast<int>(min_value + static_cast<std::int64_t>(offset));
+            }
+            break;
+
+        case Distribution::few_unique:
+            for (std::size_t i = first; i < last; ++i)
+            {
+                std::uint64_t key = generator.next_below(FEW_UNIQUE_KEYS);
+                std::uint64_t offset = static_cast<std::uint64_t>(
+                            static_cast<unsigned __int128>(key) * range / FEW_UNIQUE_KEYS);
+
+                data[i] = static_cast<int>(min_value + static_cast<std::int64_t>(offset));
+            }
+            break;
+
+        case Distribution::zipf:
+        {
+            // Zipf with exponent 1 by inverting its continuous CDF: rank = (range + 1)^u.
+            const double log_ranks = std::log(static_cast<double>(range) + 1.0);
+
+            for (std::size_t i = first; i < last; ++i)
+            {
+                std::uint64_t rank = static_cast<std::uint64_t>(std::exp(generator.next_double() * log_ranks));
+
+                if (rank < 1)
+                {
+                    rank = 1;
+                }
+                else if (rank > range)
+                {
+                    rank = range;
+                }
+
+                data[i] = static_cast<int>(min_value + static_cast<std::int64_t>(rank - 1));
+            }
+            break;
+        }
+        }
+    }
+}
+
+const char* get_distribution_name(Distribution distribution)
+{
+    switch (distribution)
+    {
+    case Distribution::uniform:
+        return "uniform";
+    case Distribution::sorted:
+        return "sorted";
+    case Distribution::reverse:
+        return "reverse";
+    case Distribution::few_unique:
+        return "few_unique";
+    case Distribution::zipf:
+        return "zipf";
+    }
+
+    return "unknown";
+}
+
+bool parse_distribution(const std::string& name, Distribution& distribution)
+{
+    const Distribution distributions[] = { Distribution::uniform, Distribution::sorted, Distribution::reverse,
+                                           Distribution::few_unique, Distribution::zipf };
+
+    for (auto candidate : distributions)
+    {
+        if (name == get_distribution_name(candidate))
+        {
+            distribution = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Xoshiro256::Xoshiro256(std::uint64_t seed)
+{
+    for (auto& word : state_)
+    {
+        word = splitmix64(seed);
+    }
+}
+
+std::uint64_t Xoshiro256::next()
+{
+    std::uint64_t result = rotate_left(state_[1] * 5, 7) * 9;
+    std::uint64_t t = state_[1] << 17;
+
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+
+    state_[2] ^= t;
+    state_[3] = rotate_left(state_[3], 45);
+
+    return result;
+}
+
+std::uint64_t Xoshiro256::next_below(std::uint64_t bound)
+{
+    // Multiply-shift instead of modulo, the bias is negligible for 64-bit output.
+    return static_cast<std::uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+}
+
+double Xoshiro256::next_double()
+{
+    return (next() >> 11) * (1.0 / 9007199254740992.0);  // 53 random bits.
+}
+
+void generate_arrays(const std::vector<ArraySpan>& arrays, Distribution distribution,
+                     int min_value, int max_value, std::uint64_t seed, ThreadPool& pool,
+                     std::size_t first_array)
+{
+    // Small arrays are grouped so a task always has about a slice of work.
+    std::size_t group_first = 0;
+    std::size_t group_elements = 0;
+
+    for (std::size_t i = 0; i < arrays.size(); ++i)
+    {
+        const ArraySpan& array = arrays[i];
+
+        if (array.size >= SLICE_SIZE)
+        {
+            for (std::size_t first = 0; first < array.size; first += SLICE_SIZE)
+            {
+                std::size_t last = std::min(first + SLICE_SIZE, array.size);
+                std::uint64_t task_seed = slice_seed(seed, first_array + i, first / SLICE_SIZE);
+
+                pool.submit([=]
+                {
+                    generate_slice(array.data, first, last, array.size, distribution, min_value, max_value, task_seed);
+                });
+            }
+        }
+        else
+        {
+            group_elements += array.size;
+        }
+
+        bool group_done = group_elements >= SLICE_SIZE || i + 1 == arrays.size();
+
+        if (group_done && group_elements != 0)
+        {
+            std::size_t group_last = i + 1;
+            const ArraySpan* spans = arrays.data();
+
+            pool.submit([=]
+            {
+                for (std::size_t j = group_first; j < group_last; ++j)
+                {
+                    if (spans[j].size < SLICE_SIZE)
+                    {
+                        generate_slice(spans[j].data, 0, spans[j].size, spans[j].size, distribution,
+                                       min_value, max_value, slice_seed(seed, first_array + j, 0));
+                    }
+                }
+            });
+
+            group_elements = 0;
+        }
+
+        if (group_elements == 0)
+        {
+            group_first = i + 1;
+        }
+    }
+
+    pool.wait();
+}
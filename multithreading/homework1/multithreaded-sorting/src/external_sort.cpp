@@ -0,0 +1,471 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "include/array_arena.h"
+#include "include/thread_pool.h"
+#include "include/data_generator.h"
+#include "include/parallel_sort.h"
+#include "include/external_sort.h"
+
+namespace
+{
+    // Size of one write() call.
+    const std::size_t WRITE_BLOCK_SIZE = 8 * 1024 * 1024;
+
+    // Elements per chunk of generate_file().
+    const std::size_t GENERATE_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    void print_error(const std::string& message, const std::string& path)
+    {
+        std::cerr << message << " " << path << ": " << std::strerror(errno) << std::endl;
+    }
+
+    // Read-only mapping of a whole file.
+    class MappedFile
+    {
+    public:
+        MappedFile() : data_(nullptr), size_(0) {}
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& path)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+
+            if (fd < 0)
+            {
+                print_error("Failed to open", path);
+                return false;
+            }
+
+            struct stat file_stat;
+
+            if (fstat(fd, &file_stat) != 0)
+            {
+                print_error("Failed to stat", path);
+                ::close(fd);
+                return false;
+            }
+
+            size_ = file_stat.st_size;
+
+            if (size_ != 0)
+            {
+                data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (data_ == MAP_FAILED)
+                {
+                    print_error("Failed to map", path);
+                    data_ = nullptr;
+                    ::close(fd);
+                    return false;
+                }
+
+                madvise(data_, size_, MADV_SEQUENTIAL);
+            }
+
+            ::close(fd);  // The mapping keeps the file.
+
+            return true;
+        }
+
+        void close()
+        {
+            if (data_ != nullptr)
+            {
+                munmap(data_, size_);
+            }
+
+            data_ = nullptr;
+            size_ = 0;
+        }
+
+        const int* get_elements() const { return static_cast<const int*>(data_); }
+        std::size_t get_elements_number() const { return size_ / sizeof(int); }
+
+    private:
+        void* data_;
+        std::size_t size_;
+    };
+
+    bool write_all(int fd, const int* data, std::size_t elements_number, const std::string& path)
+    {
+        const char* bytes = reinterpret_cast<const char*>(data);
+        std::size_t left = elements_number * sizeof(int);
+
+        while (left != 0)
+        {
+            ssize_t written = ::write(fd, bytes, std::min(left, WRITE_BLOCK_SIZE));
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                print_error("Failed to write", path);
+                return false;
+            }
+
+            bytes += written;
+            left -= written;
+        }
+
+        return true;
+    }
+
+    bool write_file(const std::string& path, const int* data, std::size_t elements_number)
+    {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0)
+        {
+            print_error("Failed to create", path);
+            return false;
+        }
+
+        bool written = write_all(fd, data, elements_number, path);
+
+        return ::close(fd) == 0 && written;
+    }
+
+    void remove_files(const std::vector<std::string>& paths)
+    {
+        for (auto& path : paths)
+        {
+            std::remove(path.c_str());
+        }
+    }
+
+    // Head of one sorted run.
+    struct RunCursor
+    {
+        const int* current;
+        const int* end;
+    };
+
+    // Tournament tree of losers: the winner is replayed against only log(k) losers
+    // on its path to the root instead of comparing with all k run heads.
+    class LoserTree
+    {
+    public:
+        explicit LoserTree(const std::vector<RunCursor>& runs) :
+            runs_(runs),
+            leaves_number_(runs.size()),
+            tree_(runs.size())
+        {
+            std::vector<std::size_t> winners(2 * leaves_number_);
+
+            for (std::size_t i = 0; i < leaves_number_; ++i)
+            {
+                winners[leaves_number_ + i] = i;
+            }
+
+            for (std::size_t node = leaves_number_ - 1; node >= 1; --node)
+            {
+                std::size_t a = winners[2 * node];
+                std::size_t b = winners[2 * node + 1];
+
+                winners[node] = is_less(a, b) ? a : b;
+                tree_[node] = is_less(a, b) ? b : a;
+            }
+
+            tree_[0] = leaves_number_ > 1 ? winners[1] : 0;
+        }
+
+        std::size_t get_winner() const { return tree_[0]; }
+        bool is_empty() const { return is_exhausted(tree_[0]); }
+
+        // The winner's cursor moved, find the new winner.
+        void replay()
+        {
+            std::size_t winner = tree_[0];
+
+            for (std::size_t node = (leaves_number_ + winner) / 2; node >= 1; node /= 2)
+            {
+                if (is_less(tree_[node], winner))
+                {
+                    std::swap(tree_[node], winner);
+                }
+            }
+
+            tree_[0] = winner;
+        }
+
+    private:
+        const std::vector<RunCursor>& runs_;
+        std::size_t leaves_number_;
+        std::vector<std::size_t> tree_;  // tree_[0] is the winner, the rest are losers of inner nodes.
+
+        bool is_exhausted(std::size_t run) const { return runs_[run].current == runs_[run].end; }
+
+        // Exhausted runs lose to everything.
+        bool is_less(std::size_t a, std::size_t b) const
+        {
+            if (is_exhausted(a))
+            {
+                return false;
+            }
+
+            return is_exhausted(b) || *runs_[a].current < *runs_[b].current;
+        }
+    };
+
+    bool merge_runs(const std::vector<std::string>& run_paths, const std::string& output_path)
+    {
+        std::vector<MappedFile> run_files(run_paths.size());
+        std::vector<RunCursor> runs;
+
+        for (std::size_t i = 0; i < run_paths.size(); ++i)
+        {
+            if (!run_files[i].open(run_paths[i]))
+            {
+                return false;
+            }
+
+            const int* elements = run_files[i].get_elements();
+            runs.push_back(RunCursor { elements, elements + run_files[i].get_elements_number() });
+        }
+
+        int fd = ::open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0)
+        {
+            print_error("Failed to create", output_path);
+            return false;
+        }
+
+        std::vector<int> buffer(WRITE_BLOCK_SIZE / sizeof(int));
+        std::size_t buffered = 0;
+        bool written = true;
+
+        LoserTree tree(runs);
+
+        while (!tree.is_empty() && written)
+        {
+            RunCursor& winner = runs[tree.get_winner()];
+
+            buffer[buffered++] = *winner.current++;
+
+            if (buffered == buffer.size())
+            {
+                written = write_all(fd, buffer.data(), buffered, output_path);
+                buffered = 0;
+            }
+
+            tree.replay();
+        }
+
+        if (written)
+        {
+            written = write_all(fd, buffer.data(), buffered, output_path);
+        }
+
+        return ::close(fd) == 0 && written;
+    }
+
+    long long get_microseconds(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds> (
+                    std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+bool external_sort(const std::string& input_path, const std::string& output_path, std::size_t memory_budget,
+                   ThreadPool& pool, ExternalSortStats& stats)
+{
+    stats = ExternalSortStats { 0, 0, 0, 0 };
+
+    MappedFile input;
+
+    if (!input.open(input_path))
+    {
+        return false;
+    }
+
+    stats.elements_number = input.get_elements_number();
+
+    // Half of the budget holds the run, the other half is the merge buffer of parallel_merge_sort().
+    std::size_t run_size = std::max<std::size_t>(memory_budget / (2 * sizeof(int)), 1);
+
+    ArrayArena arena;
+    arena.allocate(1, std::min(run_size, stats.elements_number));
+
+    std::vector<std::string> run_paths;
+
+    std::chrono::high_resolution_clock::time_point runs_start = std::chrono::high_resolution_clock::now();
+
+    for (std::size_t first = 0; first < stats.elements_number; first += run_size)
+    {
+        std::size_t size = std::min(run_size, stats.elements_number - first);
+        int* run = arena.get_arrays()[0].data;
+
+        // Copy in parallel slices, it also spreads the page faults.
+        const int* source = input.get_elements() + first;
+        unsigned int slices = pool.get_threads_number();
+
+        for (unsigned int slice = 0; slice < slices; ++slice)
+        {
+            std::size_t slice_first = size * slice / slices;
+            std::size_t slice_last = size * (slice + 1) / slices;
+
+            pool.submit([=] { std::copy(source + slice_first, source + slice_last, run + slice_first); });
+        }
+
+        pool.wait();
+
+        parallel_merge_sort(run, size, pool);
+
+        // Listed before writing, so a partly written run is removed with the others.
+        run_paths.push_back(output_path + ".run" + std::to_string(run_paths.size()));
+
+        if (!write_file(run_paths.back(), run, size))
+        {
+            remove_files(run_paths);
+            return false;
+        }
+    }
+
+    input.close();
+    arena.release();
+
+    stats.runs_number = run_paths.size();
+    stats.runs_duration = get_microseconds(runs_start);
+
+    std::chrono::high_resolution_clock::time_point merge_start = std::chrono::high_resolution_clock::now();
+
+    bool merged = true;
+
+    if (run_paths.empty())
+    {
+        merged = write_file(output_path, nullptr, 0);
+    }
+    else if (run_paths.size() == 1)
+    {
+        // Nothing to merge, the only run is the result.
+        merged = std::rename(run_paths[0].c_str(), output_path.c_str()) == 0;
+
+        if (!merged)
+        {
+            print_error("Failed to rename", run_paths[0]);
+            remove_files(run_paths);
+        }
+    }
+    else
+    {
+        // Merged into a temporary file renamed into place, so a failed merge leaves no truncated output.
+        std::string temporary_path = output_path + ".tmp";
+
+        merged = merge_runs(run_paths, temporary_path);
+        remove_files(run_paths);
+
+        if (merged && std::rename(temporary_path.c_str(), output_path.c_str()) != 0)
+        {
+            print_error("Failed to rename", temporary_path);
+            merged = false;
+        }
+
+        if (!merged)
+        {
+            std::remove(temporary_path.c_str());
+        }
+    }
+
+    stats.merge_duration = get_microseconds(merge_start);
+
+    return merged;
+}
+
+bool verify_sorted_file(const std::string& input_path, const std::string& output_path)
+{
+    MappedFile input;
+    MappedFile output;
+
+    if (!input.open(input_path) || !output.open(output_path))
+    {
+        return false;
+    }
+
+    if (input.get_elements_number() != output.get_elements_number())
+    {
+        std::cerr << "Sorted file has " << output.get_elements_number() << " elements instead of "
+                  << input.get_elements_number() << "." << std::endl;
+        return false;
+    }
+
+    const int* output_first = output.get_elements();
+    const int* output_last = output_first + output.get_elements_number();
+
+    if (!std::is_sorted(output_first, output_last))
+    {
+        std::cerr << "File is not sorted: " << output_path << std::endl;
+        return false;
+    }
+
+    // Order independent fingerprint of the keys.
+    std::uint64_t input_checksum = 0;
+    std::uint64_t output_checksum = 0;
+
+    for (std::size_t i = 0; i < input.get_elements_number(); ++i)
+    {
+        std::uint64_t input_key = static_cast<std::uint32_t>(input.get_elements()[i]);
+        std::uint64_t output_key = static_cast<std::uint32_t>(output_first[i]);
+
+        input_checksum += input_key * 0x9E3779B97F4A7C15ull ^ (input_key >> 7);
+        output_checksum += output_key * 0x9E3779B97F4A7C15ull ^ (output_key >> 7);
+    }
+
+    if (input_checksum != output_checksum)
+    {
+        std::cerr << "Sorted file keys differ from the input keys: " << output_path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool generate_file(const std::string& path, std::size_t elements_number, Distribution distribution,
+                   int min_value, int max_value, std::uint64_t seed, ThreadPool& pool)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0)
+    {
+        print_error("Failed to create", path);
+        return false;
+    }
+
+    ArrayArena arena;
+    arena.allocate(1, std::min(GENERATE_CHUNK_SIZE, elements_number));
+
+    bool written = true;
+
+    for (std::size_t first = 0; first < elements_number && written; first += GENERATE_CHUNK_SIZE)
+    {
+        std::size_t size = std::min(GENERATE_CHUNK_SIZE, elements_number - first);
+        std::vector<ArraySpan> chunk { ArraySpan { arena.get_arrays()[0].data, size } };
+
+        // Every chunk is a separately seeded array, sorted and reverse ramps restart per chunk.
+        generate_arrays(chunk, distribution, min_value, max_value, seed + first / GENERATE_CHUNK_SIZE, pool);
+
+        written = write_all(fd, chunk[0].data, size, path);
+    }
+
+    return ::close(fd) == 0 && written;
+}
@@ -0,0 +1,157 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+
+#include "include/numa_topology.h"
+
+namespace
+{
+    const char* NODES_PATH = "/sys/devices/system/node";
+
+    // "0-3,8-11" style list.
+    std::vector<unsigned int> parse_cpu_list(const std::string& list)
+    {
+        std::vector<unsigned int> cpus;
+        std::stringstream stream(list);
+        std::string range;
+
+        while (std::getline(stream, range, ','))
+        {
+            if (range.empty() || range == "\n")
+            {
+                continue;
+            }
+
+            unsigned int first = 0;
+            unsigned int last = 0;
+            std::size_t dash = range.find('-');
+
+            try
+            {
+                first = std::stoul(range.substr(0, dash));
+                last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            }
+            catch (const std::exception&)
+            {
+                continue;
+            }
+
+            for (unsigned int cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+
+        return cpus;
+    }
+
+    std::vector<unsigned int> get_allowed_cpus()
+    {
+        std::vector<unsigned int> cpus;
+        cpu_set_t set;
+
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+
+        if (cpus.empty())
+        {
+            for (unsigned int cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+
+        return cpus;
+    }
+}
+
+std::vector<NumaNode> get_numa_nodes()
+{
+    std::vector<unsigned int> allowed = get_allowed_cpus();
+    std::vector<NumaNode> nodes;
+
+    if (DIR* directory = opendir(NODES_PATH))
+    {
+        while (dirent* entry = readdir(directory))
+        {
+            std::string name = entry->d_name;
+
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4
+                    || !std::all_of(name.begin() + 4, name.end(), ::isdigit))
+            {
+                continue;
+            }
+
+            std::ifstream file(std::string(NODES_PATH) + "/" + name + "/cpulist");
+            std::string list;
+            std::getline(file, list);
+
+            NumaNode node { static_cast<unsigned int>(std::stoul(name.substr(4))), std::vector<unsigned int>() };
+
+            for (auto cpu : parse_cpu_list(list))
+            {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+                {
+                    node.cpus.push_back(cpu);
+                }
+            }
+
+            // Memory-only nodes and nodes outside our affinity mask are of no use.
+            if (!node.cpus.empty())
+            {
+                nodes.push_back(node);
+            }
+        }
+
+        closedir(directory);
+    }
+
+    if (nodes.empty())
+    {
+        nodes.push_back(NumaNode { 0, allowed });
+    }
+
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+
+    return nodes;
+}
+
+std::vector<unsigned int> get_cpus_by_node()
+{
+    std::vector<unsigned int> cpus;
+
+    for (auto& node : get_numa_nodes())
+    {
+        cpus.insert(cpus.end(), node.cpus.begin(), node.cpus.end());
+    }
+
+    return cpus;
+}
+
+bool pin_current_thread(const std::vector<unsigned int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (auto cpu : cpus)
+    {
+        CPU_SET(cpu, &set);
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+#include "include/thread_pool.h"
+#include "include/parallel_sort.h"
+
+namespace
+{
+    // Smaller inputs are not worth the extra buffer and the merge rounds.
+    const std::size_t PARALLEL_SORT_MIN_SIZE = 1 << 16;
+
+    // Number of elements of a that are among the first diagonal elements of merge(a, b).
+    std::size_t merge_path_split(const int* a, std::size_t a_size, const int* b, std::size_t b_size,
+                                 std::size_t diagonal)
+    {
+        std::size_t low = diagonal > b_size ? diagonal - b_size : 0;
+        std::size_t high = std::min(diagonal, a_size);
+
+        while (low < high)
+        {
+            std::size_t i = low + (high - low) / 2;
+
+            // Equal keys come from a first, as in std::merge.
+            if (!(b[diagonal - i - 1] < a[i]))
+            {
+                low = i + 1;
+            }
+            else
+            {
+                high = i;
+            }
+        }
+
+        return low;
+    }
+
+    void merge_runs(const int* a, std::size_t a_size, const int* b, std::size_t b_size, int* output,
+                    unsigned int parts, ThreadPool& pool)
+    {
+        std::size_t total = a_size + b_size;
+
+        for (unsigned int part = 0; part < parts; ++part)
+        {
+            std::size_t first = total * part / parts;
+            std::size_t last = total * (part + 1) / parts;
+
+            pool.submit([=]
+            {
+                std::size_t a_first = merge_path_split(a, a_size, b, b_size, first);
+                std::size_t a_last = merge_path_split(a, a_size, b, b_size, last);
+
+                std::merge(a + a_first, a + a_last, b + (first - a_first), b + (last - a_last), output + first);
+            });
+        }
+    }
+}
+
+void parallel_merge_sort(int* data, std::size_t size, ThreadPool& pool)
+{
+    unsigned int threads_number = pool.get_threads_number();
+
+    if (threads_number < 2 || size < PARALLEL_SORT_MIN_SIZE)
+    {
+        std::sort(data, data + size);
+        return;
+    }
+
+    // Run i is [bounds[i], bounds[i + 1]).
+    std::vector<std::size_t> bounds;
+
+    for (unsigned int i = 0; i <= threads_number; ++i)
+    {
+        bounds.push_back(size * i / threads_number);
+    }
+
+    for (unsigned int i = 0; i < threads_number; ++i)
+    {
+        int* first = data + bounds[i];
+        int* last = data + bounds[i + 1];
+
+        pool.submit([first, last] { std::sort(first, last); });
+    }
+
+    pool.wait();
+
+    std::vector<int> buffer(size);
+
+    int* source = data;
+    int* destination = buffer.data();
+
+    while (bounds.size() > 2)
+    {
+        std::size_t runs_number = bounds.size() - 1;
+        std::size_t pairs_number = runs_number / 2;
+        unsigned int parts = std::max(1u, static_cast<unsigned int>(threads_number / pairs_number));
+
+        std::vector<std::size_t> merged_bounds;
+
+        for (std::size_t i = 0; i + 1 < runs_number; i += 2)
+        {
+            merge_runs(source + bounds[i], bounds[i + 1] - bounds[i],
+                       source + bounds[i + 1], bounds[i + 2] - bounds[i + 1],
+                       destination + bounds[i], parts, pool);
+
+            merged_bounds.push_back(bounds[i]);
+        }
+
+        // Odd run out is carried over as is.
+        if (runs_number % 2 != 0)
+        {
+            std::size_t first = bounds[runs_number - 1];
+            std::size_t last = bounds[runs_number];
+
+            pool.submit([=] { std::copy(source + first, source + last, destination + first); });
+
+            merged_bounds.push_back(first);
+        }
+
+        merged_bounds.push_back(size);
+
+        pool.wait();
+
+        bounds.swap(merged_bounds);
+        std::swap(source, destination);
+    }
+
+    if (source != data)
+    {
+        for (unsigned int i = 0; i < threads_number; ++i)
+        {
+            std::size_t first = size * i / threads_number;
+            std::size_t last = size * (i + 1) / threads_number;
+
+            pool.submit([=] { std::copy(source + first, source + last, data + first); });
+        }
+
+        pool.wait();
+    }
+}
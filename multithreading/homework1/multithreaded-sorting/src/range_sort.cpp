@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/simd_sort.h"
+#include "include/range_sort.h"
+
+const char* get_sort_strategy_name(SortStrategy strategy)
+{
+    switch (strategy)
+    {
+    case SortStrategy::counting:
+        return "counting";
+    case SortStrategy::radix:
+        return "radix";
+    case SortStrategy::comparison:
+        return "comparison";
+    }
+
+    return "unknown";
+}
+
+SortStrategy select_sort_strategy(std::size_t size, int min_key, int max_key)
+{
+    long long range = static_cast<long long>(max_key) - min_key + 1;
+
+    if (range <= COUNTING_SORT_MAX_RANGE && range <= static_cast<long long>(size) * 4)
+    {
+        return SortStrategy::counting;
+    }
+
+    if (size >= RADIX_SORT_MIN_SIZE)
+    {
+        return SortStrategy::radix;
+    }
+
+    return SortStrategy::comparison;
+}
+
+SortStrategy range_sort(int* data, std::size_t size, int min_key, int max_key)
+{
+    SortStrategy strategy = select_sort_strategy(size, min_key, max_key);
+
+    switch (strategy)
+    {
+    case SortStrategy::counting:
+        counting_sort(data, size, min_key, max_key);
+        break;
+    case SortStrategy::radix:
+        radix_sort(data, size);
+        break;
+    case SortStrategy::comparison:
+        simd_sort(data, size);
+        break;
+    }
+
+    return strategy;
+}
+
+SortStrategy range_sort(int* data, std::size_t size)
+{
+    if (size < 2)
+    {
+        return SortStrategy::comparison;
+    }
+
+    auto range = std::minmax_element(data, data + size);
+
+    return range_sort(data, size, *range.first, *range.second);
+}
+
+void counting_sort(int* data, std::size_t size, int min_key, int max_key)
+{
+    thread_local std::vector<std::size_t> counts;
+
+    counts.assign(static_cast<std::size_t>(static_cast<long long>(max_key) - min_key + 1), 0);
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        ++counts[data[i] - static_cast<long long>(min_key)];
+    }
+
+    for (std::size_t i = 0; i < counts.size(); ++i)
+    {
+        data = std::fill_n(data, counts[i], static_cast<int>(min_key + static_cast<long long>(i)));
+    }
+}
+
+void radix_sort(int* data, std::size_t size)
+{
+    const unsigned int DIGIT_BITS = 8;
+    const unsigned int DIGITS = 1 << DIGIT_BITS;
+    const std::uint32_t SIGN_BIT = 0x80000000u;
+
+    if (size < 2)
+    {
+        return;
+    }
+
+    thread_local std::vector<std::uint32_t> buffer;
+
+    if (buffer.size() < size)
+    {
+        buffer.resize(size);
+    }
+
+    // Flipping the sign bit makes signed order equal to unsigned order.
+    std::uint32_t* source = reinterpret_cast<std::uint32_t*>(data);
+    std::uint32_t* destination = buffer.data();
+
+    std::size_t counts[4][DIGITS] = {};
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        std::uint32_t key = source[i] ^ SIGN_BIT;
+
+        for (unsigned int pass = 0; pass < 4; ++pass)
+        {
+            ++counts[pass][(key >> (pass * DIGIT_BITS)) & (DIGITS - 1)];
+        }
+    }
+
+    bool in_buffer = false;
+
+    for (unsigned int pass = 0; pass < 4; ++pass)
+    {
+        unsigned int shift = pass * DIGIT_BITS;
+        std::size_t* digit_counts = counts[pass];
+
+        // All keys share this digit, the pass would not move anything.
+        if (digit_counts[((source[0] ^ SIGN_BIT) >> shift) & (DIGITS - 1)] == size)
+        {
+            continue;
+        }
+
+        std::size_t offsets[DIGITS];
+        std::size_t offset = 0;
+
+        for (unsigned int digit = 0; digit < DIGITS; ++digit)
+        {
+            offsets[digit] = offset;
+            offset += digit_counts[digit];
+        }
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            std::uint32_t value = source[i];
+
+            destination[offsets[((value ^ SIGN_BIT) >> shift) & (DIGITS - 1)]++] = value;
+        }
+
+        std::swap(source, destination);
+        in_buffer = !in_buffer;
+    }
+
+    if (in_buffer)
+    {
+        std::copy(source, source + size, reinterpret_cast<std::uint32_t*>(data));
+    }
+}
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+#include "include/simd_sort.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_SORT_X86
+#endif
+
+#ifdef SIMD_SORT_X86
+// Defined in the per-instruction-set translation units.
+std::size_t simd_sort_avx2_padded_size(std::size_t size);
+void simd_sort_avx2(int* data, std::size_t size, int* buffer, int* scratch);
+
+std::size_t simd_sort_sse4_padded_size(std::size_t size);
+void simd_sort_sse4(int* data, std::size_t size, int* buffer, int* scratch);
+#endif
+
+namespace
+{
+    // Past this size merge passes stop fitting in cache and std::sort wins.
+    const std::size_t SIMD_SORT_MAX_SIZE = 1 << 14;
+
+    struct SortKernel
+    {
+        const char* name;
+        std::size_t (*padded_size)(std::size_t size);
+        void (*sort)(int* data, std::size_t size, int* buffer, int* scratch);
+    };
+
+    SortKernel select_kernel()
+    {
+#ifdef SIMD_SORT_X86
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SortKernel { "avx2", simd_sort_avx2_padded_size, simd_sort_avx2 };
+        }
+
+        if (__builtin_cpu_supports("sse4.1"))
+        {
+            return SortKernel { "sse4.1", simd_sort_sse4_padded_size, simd_sort_sse4 };
+        }
+#endif
+        return SortKernel { "scalar", nullptr, nullptr };
+    }
+
+    const SortKernel& get_kernel()
+    {
+        static const SortKernel kernel = select_kernel();
+
+        return kernel;
+    }
+}
+
+void simd_sort(int* data, std::size_t size)
+{
+    const SortKernel& kernel = get_kernel();
+
+    if (kernel.sort == nullptr || size < 2 || size > SIMD_SORT_MAX_SIZE)
+    {
+        std::sort(data, data + size);
+        return;
+    }
+
+    // Per-thread scratch, grown once and reused by every call.
+    thread_local std::vector<int> buffer;
+    thread_local std::vector<int> scratch;
+
+    std::size_t padded_size = kernel.padded_size(size);
+
+    if (buffer.size() < padded_size)
+    {
+        buffer.resize(padded_size);
+        scratch.resize(padded_size);
+    }
+
+    kernel.sort(data, size, buffer.data(), scratch.data());
+}
+
+const char* get_simd_sort_kernel_name()
+{
+    return get_kernel().name;
+}
@@ -0,0 +1,124 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC target("avx2")
+
+#include <cstddef>
+
+#include <immintrin.h>
+
+#include "include/simd_sort_network.h"
+
+namespace
+{
+    // Eight int lanes per register.
+    struct Avx2Vector
+    {
+        typedef __m256i Register;
+
+        static const unsigned int WIDTH = 8;
+
+        static Register load(const int* source)
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+        }
+
+        static void store(int* destination, Register value)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), value);
+        }
+
+        static void compare_exchange(Register& a, Register& b)
+        {
+            Register low = _mm256_min_epi32(a, b);
+            b = _mm256_max_epi32(a, b);
+            a = low;
+        }
+
+        // Optimal 19 comparator network for 8 inputs.
+        static void sort_columns(Register* r)
+        {
+            compare_exchange(r[0], r[2]); compare_exchange(r[1], r[3]);
+            compare_exchange(r[4], r[6]); compare_exchange(r[5], r[7]);
+
+            compare_exchange(r[0], r[4]); compare_exchange(r[1], r[5]);
+            compare_exchange(r[2], r[6]); compare_exchange(r[3], r[7]);
+
+            compare_exchange(r[0], r[1]); compare_exchange(r[2], r[3]);
+            compare_exchange(r[4], r[5]); compare_exchange(r[6], r[7]);
+
+            compare_exchange(r[2], r[4]); compare_exchange(r[3], r[5]);
+
+            compare_exchange(r[1], r[4]); compare_exchange(r[3], r[6]);
+
+            compare_exchange(r[1], r[2]); compare_exchange(r[3], r[4]); compare_exchange(r[5], r[6]);
+        }
+
+        static void transpose(Register* r)
+        {
+            Register t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+            Register t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+            Register t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+            Register t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+            Register t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+            Register t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+            Register t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+            Register t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+            Register u0 = _mm256_unpacklo_epi64(t0, t2);
+            Register u1 = _mm256_unpackhi_epi64(t0, t2);
+            Register u2 = _mm256_unpacklo_epi64(t1, t3);
+            Register u3 = _mm256_unpackhi_epi64(t1, t3);
+            Register u4 = _mm256_unpacklo_epi64(t4, t6);
+            Register u5 = _mm256_unpackhi_epi64(t4, t6);
+            Register u6 = _mm256_unpacklo_epi64(t5, t7);
+            Register u7 = _mm256_unpackhi_epi64(t5, t7);
+
+            r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+            r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+            r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+            r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+            r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+            r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+            r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+            r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+        }
+
+        // Sort a bitonic register: half-cleaners at distance 4, 2 and 1.
+        static Register sort_bitonic(Register v)
+        {
+            Register p = _mm256_permute2x128_si256(v, v, 0x01);
+            v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xF0);
+
+            p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+            v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xCC);
+
+            p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xAA);
+
+            return v;
+        }
+
+        static void merge(Register& low, Register& high)
+        {
+            Register reversed = _mm256_permutevar8x32_epi32(high, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+
+            Register smaller = _mm256_min_epi32(low, reversed);
+            Register bigger = _mm256_max_epi32(low, reversed);
+
+            low = sort_bitonic(smaller);
+            high = sort_bitonic(bigger);
+        }
+    };
+}
+
+std::size_t simd_sort_avx2_padded_size(std::size_t size)
+{
+    return network_padded_size<Avx2Vector>(size);
+}
+
+void simd_sort_avx2(int* data, std::size_t size, int* buffer, int* scratch)
+{
+    network_sort<Avx2Vector>(data, size, buffer, scratch);
+}
+
+#endif
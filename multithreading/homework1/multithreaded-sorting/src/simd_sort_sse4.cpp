@@ -0,0 +1,93 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC target("sse4.1")
+
+#include <cstddef>
+
+#include <smmintrin.h>
+
+#include "include/simd_sort_network.h"
+
+namespace
+{
+    // Four int lanes per register.
+    struct Sse4Vector
+    {
+        typedef __m128i Register;
+
+        static const unsigned int WIDTH = 4;
+
+        static Register load(const int* source)
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        }
+
+        static void store(int* destination, Register value)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), value);
+        }
+
+        static void compare_exchange(Register& a, Register& b)
+        {
+            Register low = _mm_min_epi32(a, b);
+            b = _mm_max_epi32(a, b);
+            a = low;
+        }
+
+        // Optimal 5 comparator network for 4 inputs.
+        static void sort_columns(Register* r)
+        {
+            compare_exchange(r[0], r[1]); compare_exchange(r[2], r[3]);
+            compare_exchange(r[0], r[2]); compare_exchange(r[1], r[3]);
+            compare_exchange(r[1], r[2]);
+        }
+
+        static void transpose(Register* r)
+        {
+            Register t0 = _mm_unpacklo_epi32(r[0], r[1]);
+            Register t1 = _mm_unpacklo_epi32(r[2], r[3]);
+            Register t2 = _mm_unpackhi_epi32(r[0], r[1]);
+            Register t3 = _mm_unpackhi_epi32(r[2], r[3]);
+
+            r[0] = _mm_unpacklo_epi64(t0, t1);
+            r[1] = _mm_unpackhi_epi64(t0, t1);
+            r[2] = _mm_unpacklo_epi64(t2, t3);
+            r[3] = _mm_unpackhi_epi64(t2, t3);
+        }
+
+        // Sort a bitonic register: half-cleaners at distance 2 and 1.
+        static Register sort_bitonic(Register v)
+        {
+            Register p = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+            v = _mm_blend_epi16(_mm_min_epi32(v, p), _mm_max_epi32(v, p), 0xF0);
+
+            p = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_blend_epi16(_mm_min_epi32(v, p), _mm_max_epi32(v, p), 0xCC);
+
+            return v;
+        }
+
+        static void merge(Register& low, Register& high)
+        {
+            Register reversed = _mm_shuffle_epi32(high, _MM_SHUFFLE(0, 1, 2, 3));
+
+            Register smaller = _mm_min_epi32(low, reversed);
+            Register bigger = _mm_max_epi32(low, reversed);
+
+            low = sort_bitonic(smaller);
+            high = sort_bitonic(bigger);
+        }
+    };
+}
+
+std::size_t simd_sort_sse4_padded_size(std::size_t size)
+{
+    return network_padded_size<Sse4Vector>(size);
+}
+
+void simd_sort_sse4(int* data, std::size_t size, int* buffer, int* scratch)
+{
+    network_sort<Sse4Vector>(data, size, buffer, scratch);
+}
+
+#endif
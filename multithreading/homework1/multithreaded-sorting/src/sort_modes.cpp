@@ -0,0 +1,402 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "include/array_arena.h"
+#include "include/thread_pool.h"
+#include "include/work_stealing_executor.h"
+#include "include/parallel_sort.h"
+#include "include/simd_sort.h"
+#include "include/range_sort.h"
+#include "include/sort_modes.h"
+
+// Key range the counting sort is specialized for at compile time.
+const int STATIC_MIN_VALUE = 1;
+const int STATIC_MAX_VALUE = 100;
+
+// Bigger ranges are split by the work-stealing sort.
+const std::size_t SPLIT_SIZE = 1 << 14;
+
+namespace
+{
+    struct PthreadTask
+    {
+        ArraySpan array;
+        std::size_t index;
+        sem_t* semaphore;
+        SortProgress* progress;
+    };
+
+    std::chrono::high_resolution_clock::time_point now()
+    {
+        return std::chrono::high_resolution_clock::now();
+    }
+
+    void* sort_array(void* task_pointer)
+    {
+        PthreadTask* task = (PthreadTask*) task_pointer;
+
+        sem_wait(task->semaphore);
+
+        std::chrono::high_resolution_clock::time_point start = now();
+        simd_sort(task->array.data, task->array.size);
+        task->progress->add_busy_time(now() - start);
+        task->progress->mark_sorted(task->index, task->array.size);
+
+        sem_post(task->semaphore);
+
+        return nullptr;
+    }
+
+    void sort_arrays_pthread(const std::vector<ArraySpan>& arrays, SortContext& context)
+    {
+        sem_t semaphore;
+        sem_init(&semaphore, 0, context.pool.get_threads_number());
+
+        std::vector<PthreadTask> tasks;
+        tasks.reserve(arrays.size());
+
+        for (std::size_t i = 0; i < arrays.size(); ++i)
+        {
+            tasks.push_back(PthreadTask { arrays[i], i, &semaphore, &context.progress });
+        }
+
+        std::vector<pthread_t> threads (arrays.size());
+
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+
+        for (std::size_t i = 0; i < arrays.size(); ++i)
+        {
+            if (!context.cpus.empty())
+            {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(context.cpus[i % context.cpus.size()], &cpus);
+                pthread_attr_setaffinity_np(&attributes, sizeof(cpus), &cpus);
+            }
+
+            pthread_create(&threads[i], &attributes, sort_array, &tasks[i]);
+        }
+
+        pthread_attr_destroy(&attributes);
+
+        for (auto it = threads.begin(); it != threads.end(); ++it)
+        {
+            pthread_join(*it, nullptr);
+        }
+
+        sem_destroy(&semaphore);
+    }
+
+    void sort_arrays_thread_pool(const std::vector<ArraySpan>& arrays, SortContext& context)
+    {
+        SortProgress* progress = &context.progress;
+
+        for (std::size_t i = 0; i < arrays.size(); ++i)
+        {
+            ArraySpan arr = arrays[i];
+
+            context.pool.submit([arr, i, progress]
+            {
+                std::chrono::high_resolution_clock::time_point start = now();
+                simd_sort(arr.data, arr.size);
+                progress->add_busy_time(now() - start);
+                progress->mark_sorted(i, arr.size);
+            });
+        }
+
+        context.pool.wait();
+    }
+
+    void sort_range_work_stealing(WorkStealingExecutor& executor, SortProgress& progress, std::size_t index,
+                                  int* first, int* last)
+    {
+        std::chrono::high_resolution_clock::time_point start = now();
+
+        // Split big ranges around a pivot (three-way, the keys may repeat a lot).
+        // The right part goes to this worker's deque where idle workers can steal it.
+        while (static_cast<std::size_t>(last - first) > SPLIT_SIZE)
+        {
+            int a = *first;
+            int b = first[(last - first) / 2];
+            int c = *(last - 1);
+            int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));  // Median of three.
+
+            int* equal_first = std::partition(first, last, [pivot](int value) { return value < pivot; });
+            int* equal_last = std::partition(equal_first, last, [pivot](int value) { return value == pivot; });
+
+            progress.mark_sorted(index, equal_last - equal_first);
+
+            executor.submit([&executor, &progress, index, equal_last, last]
+            {
+                sort_range_work_stealing(executor, progress, index, equal_last, last);
+            });
+
+            last = equal_first;
+        }
+
+        simd_sort(first, last - first);
+
+        progress.add_busy_time(now() - start);
+        progress.mark_sorted(index, last - first);
+    }
+
+    void sort_arrays_work_stealing(const std::vector<ArraySpan>& arrays, SortContext& context)
+    {
+        WorkStealingExecutor& executor = context.executor;
+        SortProgress& progress = context.progress;
+
+        for (std::size_t i = 0; i < arrays.size(); ++i)
+        {
+            ArraySpan arr = arrays[i];
+
+            executor.submit([&executor, &progress, arr, i]
+            {
+                sort_range_work_stealing(executor, progress, i, arr.begin(), arr.end());
+            });
+        }
+
+        executor.wait();
+    }
+
+    void sort_arrays_parallel_merge(const std::vector<ArraySpan>& arrays, SortContext& context)
+    {
+        for (std::size_t i = 0; i < arrays.size(); ++i)
+        {
+            std::chrono::high_resolution_clock::time_point start = now();
+            parallel_merge_sort(arrays[i].data, arrays[i].size, context.pool);
+
+            // Every pool thread took part.
+            context.progress.add_busy_time((now() - start) * context.pool.get_threads_number());
+            context.progress.mark_sorted(i, arrays[i].size);
+        }
+    }
+
+    void sort_array_single_thread(SortAlgorithm algorithm, ArraySpan arr, const SortContext& context)
+    {
+        switch (algorithm)
+        {
+        case SortAlgorithm::std_sort:
+            std::sort(arr.begin(), arr.end());
+            break;
+        case SortAlgorithm::counting:
+            if (context.min_value == STATIC_MIN_VALUE && context.max_value == STATIC_MAX_VALUE)
+            {
+                range_sort<STATIC_MIN_VALUE, STATIC_MAX_VALUE>(arr.data, arr.size);  // Range known at compile time.
+            }
+            else if (static_cast<long long>(context.max_value) - context.min_value < COUNTING_SORT_MAX_RANGE)
+            {
+                counting_sort(arr.data, arr.size, context.min_value, context.max_value);
+            }
+            else
+            {
+                range_sort(arr.data, arr.size, context.min_value, context.max_value);  // Too wide for counters.
+            }
+            break;
+        case SortAlgorithm::radix:
+            radix_sort(arr.data, arr.size);
+            break;
+        case SortAlgorithm::range:
+            range_sort(arr.data, arr.size);  // Range found with a min/max pass.
+            break;
+        default:
+            simd_sort(arr.data, arr.size);
+            break;
+        }
+    }
+
+    void sort_arrays_single_thread(SortAlgorithm algorithm, const std::vector<ArraySpan>& arrays, SortContext& context)
+    {
+        for (std::size_t i = 0; i < arrays.size(); ++i)
+        {
+            std::chrono::high_resolution_clock::time_point start = now();
+            sort_array_single_thread(algorithm, arrays[i], context);
+            context.progress.add_busy_time(now() - start);
+            context.progress.mark_sorted(i, arrays[i].size);
+        }
+    }
+}
+
+const char* get_sort_algorithm_name(SortAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case SortAlgorithm::std_sort:
+        return "std_sort";
+    case SortAlgorithm::single_thread:
+        return "single_thread";
+    case SortAlgorithm::pthread:
+        return "pthread";
+    case SortAlgorithm::thread_pool:
+        return "thread_pool";
+    case SortAlgorithm::work_stealing:
+        return "work_stealing";
+    case SortAlgorithm::parallel_merge:
+        return "parallel_merge";
+    case SortAlgorithm::counting:
+        return "counting";
+    case SortAlgorithm::radix:
+        return "radix";
+    case SortAlgorithm::range:
+        return "range";
+    }
+
+    return "unknown";
+}
+
+const std::vector<SortAlgorithm>& get_sort_algorithms()
+{
+    static const std::vector<SortAlgorithm> algorithms
+    {
+        SortAlgorithm::std_sort, SortAlgorithm::single_thread, SortAlgorithm::pthread,
+        SortAlgorithm::thread_pool, SortAlgorithm::work_stealing, SortAlgorithm::parallel_merge,
+        SortAlgorithm::counting, SortAlgorithm::radix, SortAlgorithm::range
+    };
+
+    return algorithms;
+}
+
+bool parse_sort_algorithm(const std::string& name, SortAlgorithm& algorithm)
+{
+    for (auto candidate : get_sort_algorithms())
+    {
+        if (name == get_sort_algorithm_name(candidate))
+        {
+            algorithm = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+SortProgress::SortProgress() :
+    busy_time_(0)
+{
+}
+
+void SortProgress::start(const std::vector<ArraySpan>& arrays)
+{
+    unsorted_.reset(new std::atomic<std::size_t>[arrays.size()]);
+
+    for (std::size_t i = 0; i < arrays.size(); ++i)
+    {
+        unsorted_[i] = arrays[i].size;
+    }
+
+    finish_.assign(arrays.size(), std::chrono::high_resolution_clock::time_point());
+    busy_time_ = 0;
+
+    start_ = now();
+
+    // Empty arrays are done from the start.
+    for (std::size_t i = 0; i < arrays.size(); ++i)
+    {
+        if (arrays[i].size == 0)
+        {
+            finish_[i] = start_;
+        }
+    }
+}
+
+void SortProgress::mark_sorted(std::size_t array_index, std::size_t count)
+{
+    if (count != 0 && unsorted_[array_index].fetch_sub(count) == count)
+    {
+        finish_[array_index] = now();
+    }
+}
+
+void SortProgress::add_busy_time(std::chrono::high_resolution_clock::duration busy_time)
+{
+    busy_time_ += std::chrono::duration_cast<std::chrono::nanoseconds> (busy_time).count();
+}
+
+long long SortProgress::get_latency(double percentile) const
+{
+    if (finish_.empty())
+    {
+        return 0;
+    }
+
+    std::vector<long long> latencies;
+    latencies.reserve(finish_.size());
+
+    for (auto& finish : finish_)
+    {
+        latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds> (finish - start_).count());
+    }
+
+    std::size_t index = std::min(latencies.size() - 1, static_cast<std::size_t>(percentile * latencies.size()));
+    std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+
+    return latencies[index];
+}
+
+double SortProgress::get_utilization(std::chrono::high_resolution_clock::duration duration,
+                                     unsigned int threads_number) const
+{
+    long long duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds> (duration).count();
+
+    if (duration_ns == 0 || threads_number == 0)
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>(busy_time_) / (static_cast<double>(duration_ns) * threads_number);
+}
+
+SortContext::SortContext(ThreadPool& pool, WorkStealingExecutor& executor, int min_value, int max_value) :
+    pool(pool),
+    executor(executor),
+    min_value(min_value),
+    max_value(max_value)
+{
+}
+
+unsigned int get_sort_threads_number(SortAlgorithm algorithm, const SortContext& context)
+{
+    switch (algorithm)
+    {
+    case SortAlgorithm::pthread:
+    case SortAlgorithm::thread_pool:
+    case SortAlgorithm::parallel_merge:
+        return context.pool.get_threads_number();
+    case SortAlgorithm::work_stealing:
+        return context.executor.get_threads_number();
+    default:
+        return 1;
+    }
+}
+
+void sort_arrays(SortAlgorithm algorithm, const std::vector<ArraySpan>& arrays, SortContext& context)
+{
+    context.progress.start(arrays);
+
+    switch (algorithm)
+    {
+    case SortAlgorithm::pthread:
+        sort_arrays_pthread(arrays, context);
+        break;
+    case SortAlgorithm::thread_pool:
+        sort_arrays_thread_pool(arrays, context);
+        break;
+    case SortAlgorithm::work_stealing:
+        sort_arrays_work_stealing(arrays, context);
+        break;
+    case SortAlgorithm::parallel_merge:
+        sort_arrays_parallel_merge(arrays, context);
+        break;
+    default:
+        sort_arrays_single_thread(algorithm, arrays, context);
+        break;
+    }
+}
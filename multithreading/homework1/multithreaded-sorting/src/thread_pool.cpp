@@ -0,0 +1,114 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "include/numa_topology.h"
+#include "include/thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned int threads_number) :
+    pending_tasks_(0),
+    stop_(false)
+{
+    start(threads_number, std::vector<unsigned int>());
+}
+
+ThreadPool::ThreadPool(unsigned int threads_number, const std::vector<unsigned int>& cpus) :
+    pending_tasks_(0),
+    stop_(false)
+{
+    start(threads_number, cpus);
+}
+
+void ThreadPool::start(unsigned int threads_number, const std::vector<unsigned int>& cpus)
+{
+    if (threads_number == 0)
+    {
+        threads_number = 1;
+    }
+
+    workers_.reserve(threads_number);
+
+    for (unsigned int i = 0; i < threads_number; ++i)
+    {
+        std::vector<unsigned int> worker_cpus;
+
+        if (!cpus.empty())
+        {
+            worker_cpus.push_back(cpus[i % cpus.size()]);
+        }
+
+        workers_.push_back(std::thread(&ThreadPool::worker_loop, this, worker_cpus));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    task_available_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(std::move(task));
+        ++pending_tasks_;
+    }
+
+    task_available_.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    tasks_finished_.wait(lock, [this] { return pending_tasks_ == 0; });
+}
+
+void ThreadPool::worker_loop(std::vector<unsigned int> cpus)
+{
+    // Pinned by the worker itself, so it never runs a task elsewhere.
+    if (!cpus.empty())
+    {
+        pin_current_thread(cpus);
+    }
+
+    for (;;)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_available_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+
+            if (tasks_.empty())
+            {
+                return;  // Stopped and nothing left to do.
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if (--pending_tasks_ == 0)
+            {
+                tasks_finished_.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+#include "include/numa_topology.h"
+#include "include/work_stealing_executor.h"
+
+namespace
+{
+    // Owning executor and worker index of the calling thread.
+    thread_local const WorkStealingExecutor* current_executor = nullptr;
+    thread_local unsigned int current_worker = 0;
+}
+
+WorkStealingExecutor::WorkStealingExecutor(unsigned int threads_number) :
+    queued_tasks_(0),
+    pending_tasks_(0),
+    next_worker_(0),
+    steals_number_(0),
+    stop_(false)
+{
+    start(threads_number, std::vector<unsigned int>());
+}
+
+WorkStealingExecutor::WorkStealingExecutor(unsigned int threads_number, const std::vector<unsigned int>& cpus) :
+    queued_tasks_(0),
+    pending_tasks_(0),
+    next_worker_(0),
+    steals_number_(0),
+    stop_(false)
+{
+    start(threads_number, cpus);
+}
+
+void WorkStealingExecutor::start(unsigned int threads_number, const std::vector<unsigned int>& cpus)
+{
+    if (threads_number == 0)
+    {
+        threads_number = 1;
+    }
+
+    workers_.reserve(threads_number);
+
+    for (unsigned int i = 0; i < threads_number; ++i)
+    {
+        workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+
+    // Start threads only after every deque exists, they steal from each other.
+    for (unsigned int i = 0; i < threads_number; ++i)
+    {
+        std::vector<unsigned int> worker_cpus;
+
+        if (!cpus.empty())
+        {
+            worker_cpus.push_back(cpus[i % cpus.size()]);
+        }
+
+        workers_[i]->thread = std::thread(&WorkStealingExecutor::worker_loop, this, i, worker_cpus);
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    task_available_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker->thread.join();
+    }
+}
+
+void WorkStealingExecutor::submit(std::function<void()> task)
+{
+    unsigned int index = (current_executor == this)
+            ? current_worker
+            : next_worker_++ % workers_.size();
+
+    {
+        // Counted under mutex_ so that a worker going to sleep cannot miss the task.
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_tasks_;
+        ++queued_tasks_;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+
+    task_available_.notify_one();
+}
+
+void WorkStealingExecutor::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    tasks_finished_.wait(lock, [this] { return pending_tasks_ == 0; });
+}
+
+bool WorkStealingExecutor::pop_task(unsigned int index, std::function<void()>& task)
+{
+    // Own deque first, newest task (its data is still hot in cache).
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task of a victim, it is usually the biggest one.
+    for (unsigned int i = 1; i < workers_.size(); ++i)
+    {
+        Worker& victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            ++steals_number_;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingExecutor::worker_loop(unsigned int index, std::vector<unsigned int> cpus)
+{
+    if (!cpus.empty())
+    {
+        pin_current_thread(cpus);
+    }
+
+    current_executor = this;
+    current_worker = index;
+
+    for (;;)
+    {
+        std::function<void()> task;
+
+        if (pop_task(index, task))
+        {
+            --queued_tasks_;
+
+            task();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if (--pending_tasks_ == 0)
+            {
+                tasks_finished_.notify_all();
+            }
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        task_available_.wait(lock, [this] { return stop_ || queued_tasks_ > 0; });
+
+        if (stop_ && queued_tasks_ == 0)
+        {
+            return;
+        }
+    }
+}
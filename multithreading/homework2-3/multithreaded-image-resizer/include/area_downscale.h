@@ -0,0 +1,97 @@
+#ifndef AREA_DOWNSCALE_H
+#define AREA_DOWNSCALE_H
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/resample_coefficients.h"
+
+// Area (box) downscale of 8-bit images with interleaved channels, in fixed point.
+// Every output pixel is the average of the source pixels under it weighted by the covered area,
+// so big reductions do not alias. Independent of OpenCV: images are plain rows of bytes.
+
+template <typename Byte>
+struct BasicPixelView
+{
+    Byte* data;
+    unsigned int width;
+    unsigned int height;
+    std::size_t step;  // Bytes between rows.
+    unsigned int channels;
+
+    Byte* get_row(unsigned int y) const { return data + y * step; }
+};
+
+typedef BasicPixelView<const unsigned char> ConstPixelView;
+typedef BasicPixelView<unsigned char> PixelView;
+
+// "avx2", "sse2" or "scalar", picked once at run time from the CPU features.
+const char* get_area_downscale_kernel_name();
+
+// Output rows [first_row, last_row) only, so row bands can run on different threads.
+// False if the output is bigger than the source on some axis or the channels differ.
+bool area_downscale(const ConstPixelView& source, const PixelView& output, unsigned int first_row, unsigned int last_row);
+bool area_downscale(const ConstPixelView& source, const PixelView& output);
+
+// Any sizes, up or down, with the area or bilinear filter, on the same fixed-point kernel.
+// Coefficient tables come from get_coefficient_cache(). False if the channels differ or a size is zero.
+bool resample(const ConstPixelView& source, const PixelView& output, ResampleFilter filter,
+              unsigned int first_row, unsigned int last_row);
+
+// Exact integer factor on both axes with the channels and the factor known at compile time:
+// plain sums and one shift instead of weights. Instantiated for 3-channel BGR with factors 2 and 4;
+// area_downscale picks it by itself.
+template <unsigned int Channels, unsigned int Factor>
+void area_downscale_integer(const ConstPixelView& source, const PixelView& output,
+                            unsigned int first_row, unsigned int last_row);
+
+// Resample of an image that arrives row by row. Only the vertical sums of the output rows
+// in progress are kept (two rows for a reduction), so the source never has to be in memory at once.
+class StreamingResampler
+{
+public:
+    // Called with every finished output row, in order from the top.
+    typedef std::function<void(unsigned int y, const unsigned char* row)> RowCallback;
+
+    StreamingResampler(unsigned int source_width, unsigned int source_height, unsigned int output_width,
+                       unsigned int output_height, unsigned int channels, ResampleFilter filter,
+                       RowCallback output_row);
+
+    StreamingResampler(const StreamingResampler&) = delete;
+    StreamingResampler& operator=(const StreamingResampler&) = delete;
+
+    // Next source row, the rows come in order from the top.
+    void push_row(const unsigned char* row);
+
+    bool is_finished() const { return next_output_row_ == output_height_; }
+
+    // Most bytes held by the rows in progress at once.
+    std::size_t get_peak_state_bytes() const;
+
+private:
+    unsigned int source_width_;
+    unsigned int output_width_;
+    unsigned int output_height_;
+    unsigned int channels_;
+
+    std::shared_ptr<const AxisCoefficients> columns_;
+    std::shared_ptr<const AxisCoefficients> rows_;
+
+    RowCallback output_row_;
+
+    unsigned int next_source_row_;
+    unsigned int next_output_row_;
+
+    // Vertical sums of output rows next_output_row_, next_output_row_ + 1, ...
+    std::deque<std::vector<std::uint32_t>> open_sums_;
+    std::vector<std::vector<std::uint32_t>> spare_sums_;
+    std::size_t peak_open_rows_;
+
+    std::vector<unsigned char> output_buffer_;
+};
+
+#endif // AREA_DOWNSCALE_H
@@ -0,0 +1,81 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// Blocking FIFO queue between pipeline stages. Producers wait while it is full,
+// so the capacity caps the memory held by the items in flight.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t capacity) :
+        capacity_(capacity > 0 ? capacity : 1),
+        closed_(false)
+    {
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Waits for a free slot. Returns false if the queue was closed, the item is dropped then.
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+
+        if (closed_)
+        {
+            return false;
+        }
+
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+
+        return true;
+    }
+
+    // Waits for an item. Returns false once the queue is closed and drained.
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+
+        if (items_.empty())
+        {
+            return false;
+        }
+
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+
+        return true;
+    }
+
+    // No more pushes, consumers still get the queued items.
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    std::deque<T> items_;
+    std::size_t capacity_;
+    bool closed_;
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+#endif // BOUNDED_QUEUE_H
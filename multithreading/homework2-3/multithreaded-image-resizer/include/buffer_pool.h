@@ -0,0 +1,66 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+#include <opencv2/opencv.hpp>
+
+// Pixel buffers reused from image to image, so steady-state processing does no pixel-buffer allocations
+// (decoders, encoders, threads and strings still allocate their own small objects).
+// Matrices draw from the pool by having it as their allocator: a released buffer goes to the free list
+// of its size bucket (powers of two) and the next matrix of that bucket takes it. The free lists hold
+// at most get_max_free_bytes() together, buffers that do not fit are freed at once.
+class BufferPool : public cv::MatAllocator
+{
+public:
+    BufferPool();
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Uninitialized image, every byte is to be written by the caller.
+    cv::Mat make_image(int rows, int cols, int type);
+
+    // Empty matrix whose create() draws from the pool, for OpenCV calls that size their output.
+    cv::Mat make_empty_image();
+
+    // Heap allocations of pixel blocks and buffer headers so far, flat once the pool is warm.
+    std::size_t get_allocations_number() const;
+    std::size_t get_reuses_number() const;
+    std::size_t get_free_bytes() const;
+
+    // Byte budget of the cached blocks, lowering it frees the biggest blocks first.
+    void set_max_free_bytes(std::size_t max_free_bytes);
+    std::size_t get_max_free_bytes() const;
+
+    // Frees the cached blocks, buffers in use are not affected.
+    void trim();
+
+    // cv::MatAllocator, called by the matrices.
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags,
+                           cv::UMatUsageFlags usage_flags) const override;
+    bool allocate(cv::UMatData* data, int access_flags, cv::UMatUsageFlags usage_flags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    mutable std::mutex mutex_;
+
+    mutable std::vector<std::vector<void*>> free_blocks_;  // By bucket.
+    mutable std::vector<void*> free_headers_;              // Storage of destroyed cv::UMatData.
+
+    mutable std::size_t allocations_number_;
+    mutable std::size_t reuses_number_;
+    mutable std::size_t free_bytes_;
+    std::size_t max_free_bytes_;
+
+    // Called with the mutex held.
+    void trim_to(std::size_t max_free_bytes) const;
+};
+
+// Shared by the resizer and the stateless API. Never destroyed, since matrices may outlive main.
+BufferPool& get_buffer_pool();
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,74 @@
+#ifndef DIRECTORY_WATCHER_H
+#define DIRECTORY_WATCHER_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <cstddef>
+
+#include "include/image_resize.h"
+#include "include/result_manifest.h"
+#include "include/thread_pool.h"
+
+// Long-running resize of a directory: images written to the input directory are resized into the output
+// directory as they arrive. Linux only, events come from inotify.
+//
+// A file is taken when it is closed after writing or moved in, so writers that rename a finished
+// temporary file into place work as well as plain writers. Events arriving close together are coalesced
+// into one batch, duplicates removed, and the batch is resized by a worker pool that lives as long as the watcher.
+// Results are kept in the ResultManifest of the output directory: on start, and whenever the kernel
+// event queue overflows, the whole input directory is reconciled against it, so images added while
+// the watcher was not running are resized and the ones already done are not.
+// Inputs are read with read() rather than mapped, since writers may still truncate them. JPEGs too big
+// to decode whole are resized in strips, and an image that fails, even with an exception, only counts as failed.
+class DirectoryWatcher
+{
+public:
+    DirectoryWatcher(const std::string& input_dir, const std::string& output_dir, const ResizeSpec& spec,
+                     unsigned int threads_number);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Watches until stop(). False if the directories can not be used or the input directory goes away.
+    bool run();
+
+    // Makes run() return after the batch in progress. Async-signal-safe, callable from any thread.
+    void stop();
+
+    std::size_t get_resized_number() const { return resized_number_; }
+    std::size_t get_failed_number() const { return failed_number_; }
+
+    const std::string JPG_EXTENSION = ".jpg";
+
+private:
+    std::string input_dir_;
+    std::string output_dir_;
+    ResizeSpec spec_;
+    std::string parameters_;
+
+    ThreadPool pool_;
+    ResultManifest manifest_;
+
+    int inotify_fd_;
+    int stop_pipe_[2];  // Written by stop(), wakes the event wait.
+
+    std::size_t resized_number_;
+    std::size_t failed_number_;
+
+    bool is_image_name(const std::string& name) const;
+    std::string get_output_path(const std::string& name) const;
+
+    // Names of all images in the input directory.
+    void scan_input_dir(std::set<std::string>& names) const;
+
+    // Reads events until they stop coming for a while. False if the watch is lost.
+    bool collect_batch(std::set<std::string>& names, bool& is_rescan_needed);
+
+    void process_batch(const std::set<std::string>& names);
+
+    static bool resize_file(const std::string& input_path, const ResizeSpec& spec, const std::string& output_path);
+};
+
+#endif // DIRECTORY_WATCHER_H
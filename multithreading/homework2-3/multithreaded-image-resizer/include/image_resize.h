@@ -0,0 +1,124 @@
+#ifndef IMAGE_RESIZE_H
+#define IMAGE_RESIZE_H
+
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "include/thread_pool.h"
+#include "include/mapped_file.h"
+#include "include/resample_coefficients.h"
+
+// Kernel of a resize.
+enum class ResizeEngine
+{
+    opencv,   // cv::resize.
+    resample  // resample_image for 8-bit images with cv::INTER_LINEAR or cv::INTER_AREA, cv::resize otherwise.
+};
+
+// Target of a resize.
+struct ResizeSpec
+{
+    unsigned int width;
+    unsigned int height;
+    int interpolation;  // cv::INTER_*.
+    ResizeEngine engine;
+
+    ResizeSpec(unsigned int width, unsigned int height, int interpolation = cv::INTER_LINEAR,
+               ResizeEngine engine = ResizeEngine::opencv);
+};
+
+// Stateless resize API. Nothing is kept between calls and the only shared objects are
+// the internal worker pool and the buffer pool, so any number of threads may call these at once.
+// Decoded and resized images live in get_buffer_pool() buffers, which return to it when released.
+// The calling thread works on its own bands too, so calls never wait for a busy pool
+// and are safe to make from the pool's own tasks.
+
+// cv::resize unless spec.engine is ResizeEngine::resample. resample_image reuses cached tables
+// across images of the same geometry, but rounds its own way: up to 1 off cv::resize in the
+// measured geometries, the difference main prints.
+cv::Mat resize_image(const cv::Mat& source, const ResizeSpec& spec);
+
+// Encoded image in memory, empty matrix if it can not be decoded. JPEGs are decoded with shrink-on-load.
+cv::Mat resize_image(ByteSpan encoded, const ResizeSpec& spec);
+
+// Encoded in, encoded out: the result is encoded in the format of extension (".jpg", ".png", ...)
+// into output, whose capacity is kept for the next call. False if decoding or encoding fails.
+bool resize_image(ByteSpan encoded, const ResizeSpec& spec, const std::string& extension,
+                  std::vector<unsigned char>& output);
+
+// File read through a memory mapping, empty matrix if it can not be read.
+cv::Mat resize_image(const std::string& source_path, const ResizeSpec& spec);
+
+// False if the image can not be read or written.
+bool resize_image_file(const std::string& source_path, const std::string& output_path, const ResizeSpec& spec);
+
+// Header fields of a JPEG file, read without decoding it.
+struct JpegInfo
+{
+    unsigned int width;
+    unsigned int height;
+    bool transposed;  // EXIF orientation swaps width and height on decode.
+};
+
+// False if the bytes are not a JPEG or its header is broken.
+bool read_jpeg_info(ByteSpan encoded, JpegInfo& info);
+bool read_jpeg_info(const std::string& path, JpegInfo& info);
+
+// Biggest DCT-domain reduction (cv::IMREAD_REDUCED_COLOR_2/4/8) that still decodes at least
+// the target size, cv::IMREAD_COLOR if there is none.
+int get_reduced_read_flag(const JpegInfo& info, const ResizeSpec& spec);
+
+// Decode into a buffer from get_buffer_pool(), empty matrix if it fails.
+cv::Mat decode_image(ByteSpan encoded, int flags = cv::IMREAD_COLOR);
+
+// Decode for the given target: JPEGs at least 2x, 4x or 8x bigger than the target are decoded
+// at reduced scale by libjpeg, which skips most of the IDCT work and the full size buffer.
+// The result still needs the exact resize.
+cv::Mat decode_image_for_resize(ByteSpan encoded, const ResizeSpec& spec);
+
+// Same for a file, read through a memory mapping.
+cv::Mat read_image_for_resize(const std::string& path, const ResizeSpec& spec);
+
+// Encoded in the format of extension (".jpg", ".png", ...). False if encoding fails.
+bool encode_image(const cv::Mat& image, const std::string& extension, std::vector<unsigned char>& output);
+
+// Encoded in the format of the path extension and written, as cv::imwrite but with
+// the encode and write stages timed separately. False if either fails.
+bool write_image(const std::string& path, const cv::Mat& image);
+
+// Several sizes from one source: halving levels are area-averaged down to the smallest size,
+// then every size is resized from the nearest level at least as big, all sizes in parallel.
+// Results are in the order of specs, empty matrices if the source is empty.
+std::vector<cv::Mat> resize_image_pyramid(const cv::Mat& source, const std::vector<ResizeSpec>& specs);
+
+// Decoded once, with shrink-on-load for the largest size.
+std::vector<cv::Mat> resize_image_pyramid(ByteSpan encoded, const std::vector<ResizeSpec>& specs);
+
+// Decoded once and output_paths[i] written with specs[i]. False if anything fails.
+bool resize_image_files(const std::string& source_path, const std::vector<ResizeSpec>& specs,
+                        const std::vector<std::string>& output_paths);
+
+// Resize of an 8-bit image with the in-project fixed-point kernel, row bands in parallel.
+// Images of the same geometry share coefficient tables through get_coefficient_cache().
+// Empty matrix if the source is not 8-bit.
+cv::Mat resample_image(const cv::Mat& source, unsigned int width, unsigned int height, ResampleFilter filter);
+
+// Area filter, empty matrix if the target is bigger on some axis.
+cv::Mat area_downscale_image(const cv::Mat& source, unsigned int width, unsigned int height);
+
+// Worker pool shared by all callers, one thread per core, started on first use.
+ThreadPool& get_resize_pool();
+
+// Threads, the caller's included, one resize is split over: at most threads_number (0: no limit),
+// at most the pool threads plus one. For benchmarks and for leaving cores to other work.
+void set_resize_threads_number(unsigned int threads_number);
+unsigned int get_resize_threads_number();
+
+// Bands a resize of input_height rows to output_height rows is split into: at most max_bands
+// and output_height, each with enough rows to pay for its task.
+unsigned int get_bands_number(unsigned int input_height, unsigned int output_height, unsigned int max_bands);
+
+#endif // IMAGE_RESIZE_H
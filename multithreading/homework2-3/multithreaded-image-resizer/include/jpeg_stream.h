@@ -0,0 +1,71 @@
+#ifndef JPEG_STREAM_H
+#define JPEG_STREAM_H
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+// JPEG files read and written a few rows at a time with libjpeg, so the whole image
+// is never in memory. Channels are RGB (or gray) in file order.
+
+// Baseline JPEGs are decoded strip by strip; progressive ones make libjpeg keep the whole
+// coefficient image, though not the pixels.
+class JpegStripReader
+{
+public:
+    JpegStripReader();
+    ~JpegStripReader();
+
+    JpegStripReader(const JpegStripReader&) = delete;
+    JpegStripReader& operator=(const JpegStripReader&) = delete;
+
+    // Reads the header. False if the file can not be opened or is not a JPEG.
+    bool open(const std::string& path);
+
+    // Size in the file, known after open.
+    unsigned int get_image_width() const;
+    unsigned int get_image_height() const;
+
+    // Starts decoding at 1/scale_denominator of the size (1, 2, 4 or 8), scaled in the DCT domain.
+    bool start(unsigned int scale_denominator);
+
+    // Size of the decoded rows, known after start.
+    unsigned int get_width() const;
+    unsigned int get_height() const;
+    unsigned int get_channels() const;
+
+    // Up to max_rows next rows, step bytes apart. Returns the rows read: fewer only at the end, 0 on failure.
+    unsigned int read_rows(unsigned char* rows, std::size_t step, unsigned int max_rows);
+
+    void close();
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+class JpegRowWriter
+{
+public:
+    JpegRowWriter();
+    ~JpegRowWriter();
+
+    JpegRowWriter(const JpegRowWriter&) = delete;
+    JpegRowWriter& operator=(const JpegRowWriter&) = delete;
+
+    // channels: 1 or 3. False if the file can not be created.
+    bool open(const std::string& path, unsigned int width, unsigned int height, unsigned int channels, int quality);
+
+    // Rows in order from the top, step bytes apart. False on failure and for rows past the image height;
+    // the writer then stays failed.
+    bool write_rows(const unsigned char* rows, std::size_t step, unsigned int rows_number);
+
+    // False if not all rows were written or the file can not be completed.
+    bool finish();
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+#endif // JPEG_STREAM_H
@@ -0,0 +1,49 @@
+#ifndef LINEAR_RESIZE_H
+#define LINEAR_RESIZE_H
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// cv::resize(input_image, output_image, output_size, 0, 0, cv::INTER_LINEAR) of 8-bit images,
+// any range of output rows at a time. The tables are made from whole-image indices with OpenCV's
+// own float and fixed-point steps, and the rows are rounded the way its vertical pass rounds them,
+// so bands split over any threads give the same image, bit for bit, as one cv::resize.
+// Builds whose cv::resize hands 8-bit linear resizes to IPP or a custom HAL may differ;
+// src/main.cpp checks the bands against cv::resize.
+class LinearResize
+{
+public:
+    // The input image is shared, not copied: it has to stay unchanged while rows are resized.
+    LinearResize(const cv::Mat& input_image, cv::Size output_size);
+
+    // 8-bit images of 1 to 4 channels, the ones resize_rows handles.
+    static bool is_supported(const cv::Mat& input_image);
+
+    // Output rows [first_row, last_row) into output_image, which has output_size and the input type.
+    // Each row reads the two input rows under it, so a band reads its halo rows by itself.
+    void resize_rows(unsigned int first_row, unsigned int last_row, cv::Mat& output_image) const;
+
+private:
+    cv::Mat input_image_;
+    cv::Size output_size_;
+    int channels_;
+
+    // 2x on both axes, which cv::resize turns into a 2x2 average.
+    bool is_half_;
+
+    // Per output element: input element of the left pixel and the weights of the left and right pixels,
+    // in 1/2048. From x_clamped_ on, the left pixel is the last one and has all the weight.
+    std::vector<int> x_offsets_;
+    std::vector<short> x_weights_;
+    int x_clamped_;
+
+    // Per output row: upper input row (-1 above the image, clamped when read) and the weights of both rows.
+    std::vector<int> y_offsets_;
+    std::vector<short> y_weights_;
+
+    void resize_row_horizontally(int input_row, int* output_row) const;
+    void average_rows(unsigned int first_row, unsigned int last_row, cv::Mat& output_image) const;
+};
+
+#endif // LINEAR_RESIZE_H
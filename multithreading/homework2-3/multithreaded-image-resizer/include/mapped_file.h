@@ -0,0 +1,47 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Read-only view of encoded bytes owned by someone else.
+struct ByteSpan
+{
+    const unsigned char* data;
+    std::size_t size;
+
+    ByteSpan() : data(nullptr), size(0) {}
+    ByteSpan(const unsigned char* data, std::size_t size) : data(data), size(size) {}
+};
+
+// Whole file mapped read-only, so decoders read it straight from the page cache
+// without a copy into a user buffer.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False (errno set) if the file can not be opened or mapped.
+    bool open(const std::string& path);
+    void close();
+
+    ByteSpan get_bytes() const { return ByteSpan(static_cast<const unsigned char*>(data_), size_); }
+
+private:
+    void* data_;
+    std::size_t size_;
+};
+
+// Whole file copied into bytes with read(), for files other processes may still be writing: reading
+// pages of a mapped file that was truncated meanwhile raises SIGBUS, read() just returns fewer bytes.
+// At most max_size bytes from the start. The capacity of bytes is kept for the next call.
+// False (errno set) if the file can not be read.
+bool read_file(const std::string& path, std::vector<unsigned char>& bytes,
+               std::size_t max_size = static_cast<std::size_t>(-1));
+
+#endif // MAPPED_FILE_H
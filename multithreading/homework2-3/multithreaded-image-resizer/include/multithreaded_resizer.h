@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <thread>
+#include <algorithm>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
@@ -30,21 +31,57 @@ public:
                                    unsigned int output_height,
                                    const std::string& output_image_path);
 
-    // Resize the directory of images.
+    // Parallel over bands of output rows, one thread each. 8-bit images are resized with LinearResize,
+    // whose rows do not depend on the split: the same image, bit for bit, as resize_image_single_thread.
+    // Other depths go to one cv::resize, which OpenCV splits over rows by itself.
+    cv::Mat resize_image_bands(const std::string& input_image_path,
+                               unsigned int output_width,
+                               unsigned int output_height,
+                               const std::string& output_image_path);
+
+    // JPEG to JPEG in strips: the input image is never decoded as a whole, so inputs bigger
+    // than memory work. Does not touch the input and output images. False if anything fails.
+    bool resize_image_streaming(const std::string& input_image_path,
+                                unsigned int output_width,
+                                unsigned int output_height,
+                                const std::string& output_image_path);
+
+    // Resize the directory of images. Images resized by an earlier run with the same size are skipped
+    // if neither they nor their outputs changed, as recorded in the ResultManifest of the output directory.
     void resize_images_std_async(const std::string& input_images_dir,
                                  unsigned int output_width,
                                  unsigned int output_height,
                                  const std::string& output_images_dir);
 
+    // Resize the directory tree of images in a pipeline: parallel directory scanning,
+    // decoder threads, resize threads and encoder threads joined by bounded queues,
+    // so decoding and encoding of different files overlap and the queue depths cap the memory.
+    // Output tree mirrors the input one, links to directories are not followed. Files that fail
+    // in any stage, exceptions of OpenCV or of allocation included, are reported and skipped.
+    void resize_images_pipeline(const std::string& input_images_dir,
+                                unsigned int output_width,
+                                unsigned int output_height,
+                                const std::string& output_images_dir);
+
     cv::Mat get_input_image() { return input_image_; }
     cv::Mat get_output_image() { return output_image_; }
 
     static void show_image(const cv::Mat& image);
     static unsigned int get_cores_number();
 
+    // Threads the parallel modes are sized for, get_cores_number() by default.
+    void set_threads_number(unsigned int threads_number) { threads_number_ = std::max(threads_number, 1u); }
+    unsigned int get_threads_number() const { return threads_number_; }
+
+    // Threads resize_image_std_thread and resize_image_std_async actually run: one per tile
+    // of a (threads / 2) x (threads / 2) grid, so 1 for 1 to 3 threads and 16 for 8.
+    unsigned int get_tiles_number() const { return get_tile_grid_size() * get_tile_grid_size(); }
+
     const std::string JPG_EXTENSION = ".jpg";
 
 private:
+    unsigned int threads_number_;
+
     cv::Mat input_image_;
     unsigned int input_image_width_;
     unsigned int input_image_height_;
@@ -61,12 +98,13 @@ private:
     unsigned int columns_to_split_;
     unsigned int rows_to_split_;
 
+    unsigned int get_tile_grid_size() const { return std::max(threads_number_ / 2, 1u); }
+
     void read_image(const std::string& image_path);
     void save_image(const cv::Mat& image, const std::string& path);
 
-    // Main image processing fuction.
-    static void process_chunk(cv::Mat& input_image, unsigned int chunk_width, unsigned int chunk_height,
-                              unsigned int new_chunk_width, unsigned int new_chunk_height,
+    // Main image processing fuction: tile (x, y) of a columns x rows grid.
+    static void process_chunk(const cv::Mat& input_image, unsigned int columns, unsigned int rows,
                               unsigned int x, unsigned int y, cv::Mat& output_image);
 
     /* Utility functions (they were needed for testing etc.) */
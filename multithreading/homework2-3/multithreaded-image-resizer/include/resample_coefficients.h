@@ -0,0 +1,75 @@
+#ifndef RESAMPLE_COEFFICIENTS_H
+#define RESAMPLE_COEFFICIENTS_H
+
+#include <map>
+#include <list>
+#include <tuple>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+enum class ResampleFilter
+{
+    area,
+    linear  // Two taps at pixel centers, as cv::INTER_LINEAR.
+};
+
+// Fixed-point coefficients: the weights of one output pixel sum to RESAMPLE_WEIGHT_ONE exactly.
+const unsigned int RESAMPLE_WEIGHT_BITS = 11;
+const std::uint32_t RESAMPLE_WEIGHT_ONE = 1u << RESAMPLE_WEIGHT_BITS;
+
+// Source pixels under every output pixel of one axis and their weights.
+struct AxisCoefficients
+{
+    std::vector<unsigned int> first;    // First source pixel of every output pixel.
+    std::vector<unsigned int> offsets;  // Weights of output pixel i: [offsets[i], offsets[i + 1]), consecutive pixels.
+    std::vector<std::uint32_t> weights;
+};
+
+AxisCoefficients make_axis_coefficients(unsigned int source_size, unsigned int output_size, ResampleFilter filter);
+
+// Process-wide cache of axis coefficients keyed by geometry and filter, so images of the same
+// size share their tables. Thread-safe, the least recently used tables go first when it is full.
+class CoefficientCache
+{
+public:
+    explicit CoefficientCache(std::size_t capacity);
+
+    CoefficientCache(const CoefficientCache&) = delete;
+    CoefficientCache& operator=(const CoefficientCache&) = delete;
+
+    // Built outside the lock on a miss. Tables stay valid while the pointer is held.
+    std::shared_ptr<const AxisCoefficients> get(unsigned int source_size, unsigned int output_size,
+                                                ResampleFilter filter);
+
+    void clear();
+
+    std::size_t get_hits() const;
+    std::size_t get_misses() const;
+    double get_hit_rate() const;
+
+private:
+    typedef std::tuple<unsigned int, unsigned int, ResampleFilter> Key;
+
+    struct Entry
+    {
+        std::shared_ptr<const AxisCoefficients> coefficients;
+        std::list<Key>::iterator use;
+    };
+
+    std::size_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::map<Key, Entry> entries_;
+    std::list<Key> uses_;  // Most recent first.
+
+    std::size_t hits_;
+    std::size_t misses_;
+};
+
+// The cache used by the resampling kernels.
+CoefficientCache& get_coefficient_cache();
+
+#endif // RESAMPLE_COEFFICIENTS_H
@@ -0,0 +1,186 @@
+#ifndef RESIZER_STATS_H
+#define RESIZER_STATS_H
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+// Always-on instrumentation of the resizer: latency histograms of the stages every image goes through,
+// queue depths, worker utilization and encoded bytes. Every update is a few relaxed atomic additions,
+// made once per image and stage (once per task for the pools), so it costs nothing next to the work measured.
+
+enum class Stage
+{
+    read,    // Getting the input bytes: opening and mapping the file, whose pages the decoder then reads,
+             // or copying it with read() in the directory watcher (only the header for JPEGs resized in strips).
+    decode,
+    resize,
+    encode,
+    write
+};
+
+enum class StatsQueue
+{
+    pool_tasks,        // Every ThreadPool.
+    pipeline_files,
+    pipeline_decoded,
+    pipeline_resized
+};
+
+const unsigned int STAGES_NUMBER = 5;
+const unsigned int STATS_QUEUES_NUMBER = 4;
+
+// Bucket 0 counts latencies under 1 microsecond, bucket b the ones in [2^(b-1), 2^b) microseconds.
+const unsigned int LATENCY_BUCKETS_NUMBER = 32;
+
+const char* get_stage_name(Stage stage);
+const char* get_queue_name(StatsQueue queue);
+
+struct LatencySnapshot
+{
+    std::uint64_t count;
+    std::uint64_t total_ns;
+    std::uint64_t max_ns;
+    std::uint64_t buckets[LATENCY_BUCKETS_NUMBER];
+
+    double get_mean_us() const;
+
+    // Upper bound of the bucket holding the percentile (0..100), at most the maximum.
+    double get_percentile_us(double percentile) const;
+};
+
+struct QueueSnapshot
+{
+    std::int64_t depth;
+    std::int64_t max_depth;
+    std::uint64_t pushes;
+};
+
+struct ResizerStatsSnapshot
+{
+    double uptime_seconds;
+
+    LatencySnapshot stages[STAGES_NUMBER];
+    QueueSnapshot queues[STATS_QUEUES_NUMBER];
+
+    unsigned int workers_number;
+    std::uint64_t worker_busy_ns;
+    std::uint64_t worker_capacity_ns;  // Sum of the lifetimes of the workers so far.
+
+    std::uint64_t bytes_in;   // Encoded input.
+    std::uint64_t bytes_out;  // Encoded output.
+
+    // Part of the worker time spent running tasks, 0..1.
+    double get_worker_utilization() const;
+};
+
+class ResizerStats
+{
+public:
+    ResizerStats();
+
+    ResizerStats(const ResizerStats&) = delete;
+    ResizerStats& operator=(const ResizerStats&) = delete;
+
+    void add_latency(Stage stage, std::uint64_t duration_ns);
+
+    // change: +1 after a push, -1 after a pop.
+    void add_queue_depth(StatsQueue queue, int change);
+
+    // Worker threads started (positive change) or stopped (negative).
+    void add_workers(int change);
+    void add_busy_time(std::uint64_t duration_ns);
+
+    void add_bytes_in(std::uint64_t bytes) { bytes_in_.fetch_add(bytes, std::memory_order_relaxed); }
+    void add_bytes_out(std::uint64_t bytes) { bytes_out_.fetch_add(bytes, std::memory_order_relaxed); }
+
+    // Counters read one by one while others update them: each is exact, together they are nearly consistent.
+    ResizerStatsSnapshot get_stats() const;
+
+private:
+    struct Histogram
+    {
+        std::atomic<std::uint64_t> count;
+        std::atomic<std::uint64_t> total_ns;
+        std::atomic<std::uint64_t> max_ns;
+        std::atomic<std::uint64_t> buckets[LATENCY_BUCKETS_NUMBER];
+    };
+
+    struct QueueCounters
+    {
+        std::atomic<std::int64_t> depth;
+        std::atomic<std::int64_t> max_depth;
+        std::atomic<std::uint64_t> pushes;
+    };
+
+    std::chrono::steady_clock::time_point start_;
+
+    Histogram stages_[STAGES_NUMBER];
+    QueueCounters queues_[STATS_QUEUES_NUMBER];
+
+    // Capacity changes only when pools start or stop, so it is kept under a mutex.
+    mutable std::mutex workers_mutex_;
+    unsigned int workers_number_;
+    std::uint64_t worker_capacity_ns_;
+    std::chrono::steady_clock::time_point workers_changed_;
+
+    std::atomic<std::uint64_t> worker_busy_ns_;
+
+    std::atomic<std::uint64_t> bytes_in_;
+    std::atomic<std::uint64_t> bytes_out_;
+};
+
+// Shared by everything in the process. Never destroyed, since pools may outlive main.
+ResizerStats& get_resizer_stats();
+
+ResizerStatsSnapshot get_stats();
+
+// One JSON object, no line breaks.
+std::string stats_to_json(const ResizerStatsSnapshot& stats);
+
+// Adds the lifetime of the scope to a stage.
+class StageTimer
+{
+public:
+    explicit StageTimer(Stage stage);
+    ~StageTimer();
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Writes get_stats() as JSON to a file every interval and once more when destroyed. The file is replaced
+// by renaming, so readers always see a whole snapshot.
+class StatsReporter
+{
+public:
+    StatsReporter(const std::string& path, unsigned int interval_ms);
+    ~StatsReporter();
+
+    StatsReporter(const StatsReporter&) = delete;
+    StatsReporter& operator=(const StatsReporter&) = delete;
+
+private:
+    std::string path_;
+    std::chrono::milliseconds interval_;
+
+    std::mutex mutex_;
+    std::condition_variable stop_requested_;
+    bool stop_;
+
+    std::thread thread_;
+
+    void report_loop();
+    bool write_report() const;
+};
+
+#endif // RESIZER_STATS_H
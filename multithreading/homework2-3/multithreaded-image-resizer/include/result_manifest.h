@@ -0,0 +1,99 @@
+#ifndef RESULT_MANIFEST_H
+#define RESULT_MANIFEST_H
+
+#include <map>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/mapped_file.h"
+
+// Fast non-cryptographic 64-bit hash of the bytes (xxHash64), for telling changed inputs apart.
+std::uint64_t hash_bytes(ByteSpan bytes);
+
+// Same hash of bytes that come in pieces of any sizes: the result does not depend on the split.
+class StreamingHash
+{
+public:
+    StreamingHash();
+
+    void update(ByteSpan bytes);
+
+    // Hash of all bytes so far. More may follow.
+    std::uint64_t get_hash() const;
+
+private:
+    std::uint64_t lanes_[4];
+
+    // Start of the next 32-byte stripe.
+    unsigned char stripe_[32];
+    std::size_t stripe_size_;
+
+    std::uint64_t total_size_;
+};
+
+// Hash of the file contents, read in pieces. False if the file can not be read.
+bool hash_file(const std::string& path, std::uint64_t& hash);
+
+// Results of earlier runs over a directory, kept in a text file next to the outputs. An output is
+// up to date if it is the one recorded for its input, with the same input contents and resize parameters.
+// Input contents are rehashed only when the input size or modification time changed since the record.
+// Not synchronized: one thread uses it at a time.
+class ResultManifest
+{
+public:
+    ResultManifest();
+
+    // Missing or unreadable file gives an empty manifest.
+    void load(const std::string& path);
+
+    // Written to a temporary file and renamed, so a crash never leaves a half-written manifest. False on failure.
+    bool save() const;
+
+    // True if output_path holds the result of input_path with the parameters. Otherwise the input is to be
+    // processed and its content hash is kept until its record.
+    bool is_up_to_date(const std::string& input_path, const std::string& parameters, const std::string& output_path);
+
+    // The output was written from the input as it was when checked by is_up_to_date.
+    void record(const std::string& input_path, const std::string& parameters, const std::string& output_path);
+
+    std::size_t get_hits() const { return hits_; }
+    std::size_t get_misses() const { return misses_; }
+
+    static const std::string FILE_NAME;
+
+private:
+    // File size and modification time in nanoseconds.
+    struct FileState
+    {
+        std::uint64_t size;
+        std::int64_t time;
+
+        FileState() : size(0), time(0) {}
+        bool operator==(const FileState& other) const { return size == other.size && time == other.time; }
+    };
+
+    struct Entry
+    {
+        std::uint64_t content_hash;
+        FileState input;
+        FileState output;
+        std::string parameters;
+        std::string output_path;
+
+        Entry() : content_hash(0) {}
+    };
+
+    static bool get_file_state(const std::string& path, FileState& state);
+
+    std::string path_;
+    std::map<std::string, Entry> entries_;  // By input path.
+
+    // Inputs checked and waiting for their records.
+    std::map<std::string, Entry> checked_;
+
+    std::size_t hits_;
+    std::size_t misses_;
+};
+
+#endif // RESULT_MANIFEST_H
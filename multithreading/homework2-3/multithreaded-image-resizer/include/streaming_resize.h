@@ -0,0 +1,30 @@
+#ifndef STREAMING_RESIZE_H
+#define STREAMING_RESIZE_H
+
+#include <string>
+#include <cstddef>
+
+#include "include/image_resize.h"
+
+// Rows decoded per strip; libjpeg works in blocks of 8 or 16 rows.
+const unsigned int STREAMING_STRIP_ROWS = 16;
+
+struct StreamingStats
+{
+    unsigned int decoded_width;   // After DCT-domain scaling.
+    unsigned int decoded_height;
+    std::size_t peak_buffer_bytes;  // Strip, rows in progress and the output row.
+};
+
+// JPEG to JPEG resize that never holds the whole image, for inputs bigger than memory:
+// strips of the source are decoded (scaled by 1/2, 1/4 or 1/8 in the DCT domain when the target
+// is that much smaller), pushed through a StreamingResampler and every finished output row is
+// encoded right away. cv::INTER_AREA resizes with the area filter, everything else is bilinear.
+// EXIF orientation is not applied. False (and no output file) if anything fails.
+bool resize_jpeg_streaming(const std::string& source_path, const std::string& output_path, const ResizeSpec& spec,
+                           int quality = 95, StreamingStats* stats = nullptr);
+
+// Synthetic RGB test image of any size, written row by row with little memory.
+bool write_synthetic_jpeg(const std::string& path, unsigned int width, unsigned int height, int quality = 90);
+
+#endif // STREAMING_RESIZE_H
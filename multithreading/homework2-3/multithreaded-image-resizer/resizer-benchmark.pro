@@ -0,0 +1,48 @@
+TEMPLATE = app
+TARGET = resizer-benchmark
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+
+QMAKE_CXXFLAGS += -std=c++0x -pthread
+LIBS += -pthread
+
+LIBS += -L/usr/lib/ -lboost_system -lboost_filesystem
+
+INCLUDEPATH += /usr/local/include/opencv
+LIBS += -L/usr/local/lib -lopencv_core -lopencv_imgcodecs -lopencv_highgui -lopencv_imgproc
+
+LIBS += -ljpeg
+
+SOURCES += src/resizer_benchmark.cpp \
+    src/multithreaded_resizer.cpp \
+    src/image_resize.cpp \
+    src/linear_resize.cpp \
+    src/thread_pool.cpp \
+    src/mapped_file.cpp \
+    src/area_downscale.cpp \
+    src/area_downscale_sse2.cpp \
+    src/area_downscale_avx2.cpp \
+    src/resample_coefficients.cpp \
+    src/buffer_pool.cpp \
+    src/jpeg_stream.cpp \
+    src/streaming_resize.cpp \
+    src/result_manifest.cpp \
+    src/directory_watcher.cpp \
+    src/resizer_stats.cpp
+
+HEADERS += \
+    include/multithreaded_resizer.h \
+    include/bounded_queue.h \
+    include/image_resize.h \
+    include/linear_resize.h \
+    include/thread_pool.h \
+    include/mapped_file.h \
+    include/area_downscale.h \
+    include/resample_coefficients.h \
+    include/buffer_pool.h \
+    include/jpeg_stream.h \
+    include/streaming_resize.h \
+    include/result_manifest.h \
+    include/directory_watcher.h \
+    include/resizer_stats.h
@@ -0,0 +1,377 @@
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/area_downscale.h"
+#include "include/resample_coefficients.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define AREA_DOWNSCALE_X86
+#endif
+
+#ifdef AREA_DOWNSCALE_X86
+// Defined in the per-instruction-set translation units.
+void area_add_row_avx2(const unsigned char* row, std::uint16_t* sums, std::size_t size);
+void area_add_weighted_row_avx2(const unsigned char* row, std::uint32_t weight, std::uint32_t* sums, std::size_t size);
+void area_add_shifted_avx2(const std::uint16_t* values, std::size_t shift, std::uint16_t* sums, std::size_t size);
+
+void area_add_row_sse2(const unsigned char* row, std::uint16_t* sums, std::size_t size);
+void area_add_weighted_row_sse2(const unsigned char* row, std::uint32_t weight, std::uint32_t* sums, std::size_t size);
+void area_add_shifted_sse2(const std::uint16_t* values, std::size_t shift, std::uint16_t* sums, std::size_t size);
+#endif
+
+namespace
+{
+    // A row sum is at most 255 << 11 and the product of both axes at most 255 << 22, so 32 bits hold it.
+    const unsigned int WEIGHT_BITS = RESAMPLE_WEIGHT_BITS;
+    const std::uint32_t ROUNDING = 1u << (2 * WEIGHT_BITS - 1);
+
+    struct AreaKernel
+    {
+        const char* name;
+
+        // sums[i] += row[i]
+        void (*add_row)(const unsigned char* row, std::uint16_t* sums, std::size_t size);
+
+        // sums[i] += row[i] * weight, weight at most RESAMPLE_WEIGHT_ONE.
+        void (*add_weighted_row)(const unsigned char* row, std::uint32_t weight, std::uint32_t* sums,
+                                 std::size_t size);
+
+        // sums[i] += values[i + shift]
+        void (*add_shifted)(const std::uint16_t* values, std::size_t shift, std::uint16_t* sums, std::size_t size);
+    };
+
+    void add_row_scalar(const unsigned char* row, std::uint16_t* sums, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            sums[i] += row[i];
+        }
+    }
+
+    void add_weighted_row_scalar(const unsigned char* row, std::uint32_t weight, std::uint32_t* sums, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            sums[i] += row[i] * weight;
+        }
+    }
+
+    void add_shifted_scalar(const std::uint16_t* values, std::size_t shift, std::uint16_t* sums, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            sums[i] += values[i + shift];
+        }
+    }
+
+    AreaKernel select_kernel()
+    {
+#ifdef AREA_DOWNSCALE_X86
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return AreaKernel { "avx2", area_add_row_avx2, area_add_weighted_row_avx2, area_add_shifted_avx2 };
+        }
+
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return AreaKernel { "sse2", area_add_row_sse2, area_add_weighted_row_sse2, area_add_shifted_sse2 };
+        }
+#endif
+        return AreaKernel { "scalar", add_row_scalar, add_weighted_row_scalar, add_shifted_scalar };
+    }
+
+    const AreaKernel& get_kernel()
+    {
+        static const AreaKernel kernel = select_kernel();
+
+        return kernel;
+    }
+
+    // Horizontal pass over the vertically weighted sums of one output row.
+    template <unsigned int Channels>
+    void reduce_columns(const std::uint32_t* sums, const AxisCoefficients& columns, unsigned int width,
+                        unsigned char* output)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            const std::uint32_t* pixel = sums + std::size_t(columns.first[x]) * Channels;
+            std::uint32_t totals[Channels];
+
+            for (unsigned int c = 0; c < Channels; ++c)
+            {
+                totals[c] = ROUNDING;
+            }
+
+            for (unsigned int k = columns.offsets[x]; k < columns.offsets[x + 1]; ++k, pixel += Channels)
+            {
+                for (unsigned int c = 0; c < Channels; ++c)
+                {
+                    totals[c] += pixel[c] * columns.weights[k];
+                }
+            }
+
+            for (unsigned int c = 0; c < Channels; ++c)
+            {
+                output[c] = static_cast<unsigned char>(totals[c] >> (2 * WEIGHT_BITS));
+            }
+
+            output += Channels;
+        }
+    }
+
+    void reduce_columns(const std::uint32_t* sums, const AxisCoefficients& columns, unsigned int width,
+                        unsigned int channels, unsigned char* output)
+    {
+        switch (channels)
+        {
+        case 1:
+            reduce_columns<1>(sums, columns, width, output);
+            return;
+        case 3:
+            reduce_columns<3>(sums, columns, width, output);
+            return;
+        case 4:
+            reduce_columns<4>(sums, columns, width, output);
+            return;
+        }
+
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            for (unsigned int c = 0; c < channels; ++c)
+            {
+                const std::uint32_t* pixel = sums + std::size_t(columns.first[x]) * channels + c;
+                std::uint32_t total = ROUNDING;
+
+                for (unsigned int k = columns.offsets[x]; k < columns.offsets[x + 1]; ++k, pixel += channels)
+                {
+                    total += *pixel * columns.weights[k];
+                }
+
+                *output++ = static_cast<unsigned char>(total >> (2 * WEIGHT_BITS));
+            }
+        }
+    }
+
+    // Any sizes and filter: separable weights from the shared cache, the vertical pass vectorized over whole rows.
+    void resample_weighted(const ConstPixelView& source, const PixelView& output, ResampleFilter filter,
+                           unsigned int first_row, unsigned int last_row)
+    {
+        const AreaKernel& kernel = get_kernel();
+        CoefficientCache& cache = get_coefficient_cache();
+
+        std::shared_ptr<const AxisCoefficients> columns = cache.get(source.width, output.width, filter);
+        std::shared_ptr<const AxisCoefficients> rows = cache.get(source.height, output.height, filter);
+
+        std::size_t row_size = std::size_t(source.width) * source.channels;
+
+        // Per-thread row of sums, grown once and reused by every call.
+        thread_local std::vector<std::uint32_t> sums;
+
+        if (sums.size() < row_size)
+        {
+            sums.resize(row_size);
+        }
+
+        for (unsigned int y = first_row; y < last_row; ++y)
+        {
+            std::fill(sums.begin(), sums.begin() + row_size, 0);
+
+            for (unsigned int k = rows->offsets[y]; k < rows->offsets[y + 1]; ++k)
+            {
+                const unsigned char* row = source.get_row(rows->first[y] + (k - rows->offsets[y]));
+
+                kernel.add_weighted_row(row, rows->weights[k], sums.data(), row_size);
+            }
+
+            reduce_columns(sums.data(), *columns, output.width, output.channels, output.get_row(y));
+        }
+    }
+}
+
+const char* get_area_downscale_kernel_name()
+{
+    return get_kernel().name;
+}
+
+template <unsigned int Channels, unsigned int Factor>
+void area_downscale_integer(const ConstPixelView& source, const PixelView& output,
+                            unsigned int first_row, unsigned int last_row)
+{
+    static_assert(Factor >= 2 && Factor * Factor * 255 <= 0xFFFF, "Block sums must fit 16 bits.");
+
+    const unsigned int AREA = Factor * Factor;
+    const AreaKernel& kernel = get_kernel();
+
+    std::size_t row_size = std::size_t(output.width) * Factor * Channels;
+
+    // Sum of Factor neighbours starting at every byte, only every Factor-th pixel is kept.
+    std::size_t block_size = row_size - (Factor - 1) * Channels;
+
+    thread_local std::vector<std::uint16_t> row_sums;
+    thread_local std::vector<std::uint16_t> block_sums;
+
+    if (row_sums.size() < row_size)
+    {
+        row_sums.resize(row_size);
+        block_sums.resize(row_size);
+    }
+
+    for (unsigned int y = first_row; y < last_row; ++y)
+    {
+        std::fill(row_sums.begin(), row_sums.begin() + row_size, 0);
+
+        for (unsigned int k = 0; k < Factor; ++k)
+        {
+            kernel.add_row(source.get_row(y * Factor + k), row_sums.data(), row_size);
+        }
+
+        std::copy(row_sums.begin(), row_sums.begin() + block_size, block_sums.begin());
+
+        for (unsigned int k = 1; k < Factor; ++k)
+        {
+            kernel.add_shifted(row_sums.data(), k * Channels, block_sums.data(), block_size);
+        }
+
+        const std::uint16_t* block = block_sums.data();
+        unsigned char* pixel = output.get_row(y);
+
+        for (unsigned int x = 0; x < output.width; ++x, block += Factor * Channels, pixel += Channels)
+        {
+            for (unsigned int c = 0; c < Channels; ++c)
+            {
+                pixel[c] = static_cast<unsigned char>((block[c] + AREA / 2) / AREA);
+            }
+        }
+    }
+}
+
+template void area_downscale_integer<3, 2>(const ConstPixelView&, const PixelView&, unsigned int, unsigned int);
+template void area_downscale_integer<3, 4>(const ConstPixelView&, const PixelView&, unsigned int, unsigned int);
+
+bool area_downscale(const ConstPixelView& source, const PixelView& output, unsigned int first_row, unsigned int last_row)
+{
+    if (source.channels == 0 || source.channels != output.channels || output.width == 0 || output.height == 0
+        || output.width > source.width || output.height > source.height
+        || first_row > last_row || last_row > output.height)
+    {
+        return false;
+    }
+
+    if (source.channels == 3 && source.width == output.width * 2 && source.height == output.height * 2)
+    {
+        area_downscale_integer<3, 2>(source, output, first_row, last_row);
+    }
+    else if (source.channels == 3 && source.width == output.width * 4 && source.height == output.height * 4)
+    {
+        area_downscale_integer<3, 4>(source, output, first_row, last_row);
+    }
+    else
+    {
+        resample_weighted(source, output, ResampleFilter::area, first_row, last_row);
+    }
+
+    return true;
+}
+
+bool area_downscale(const ConstPixelView& source, const PixelView& output)
+{
+    return area_downscale(source, output, 0, output.height);
+}
+
+bool resample(const ConstPixelView& source, const PixelView& output, ResampleFilter filter,
+              unsigned int first_row, unsigned int last_row)
+{
+    if (filter == ResampleFilter::area && output.width <= source.width && output.height <= source.height)
+    {
+        return area_downscale(source, output, first_row, last_row);
+    }
+
+    if (source.channels == 0 || source.channels != output.channels || source.width == 0 || source.height == 0
+        || output.width == 0 || output.height == 0 || first_row > last_row || last_row > output.height)
+    {
+        return false;
+    }
+
+    resample_weighted(source, output, filter, first_row, last_row);
+
+    return true;
+}
+
+StreamingResampler::StreamingResampler(unsigned int source_width, unsigned int source_height, unsigned int output_width,
+                                       unsigned int output_height, unsigned int channels, ResampleFilter filter,
+                                       RowCallback output_row) :
+    source_width_(source_width),
+    output_width_(output_width),
+    output_height_(output_height),
+    channels_(channels),
+    columns_(get_coefficient_cache().get(source_width, output_width, filter)),
+    rows_(get_coefficient_cache().get(source_height, output_height, filter)),
+    output_row_(std::move(output_row)),
+    next_source_row_(0),
+    next_output_row_(0),
+    peak_open_rows_(0),
+    output_buffer_(std::size_t(output_width) * channels)
+{
+}
+
+void StreamingResampler::push_row(const unsigned char* row)
+{
+    const AreaKernel& kernel = get_kernel();
+
+    unsigned int s = next_source_row_++;
+    std::size_t row_size = std::size_t(source_width_) * channels_;
+
+    // Output rows whose taps include this row. Rows start and end in order, so they are the open
+    // rows plus the ones starting here.
+    for (unsigned int y = next_output_row_; y < output_height_ && rows_->first[y] <= s; ++y)
+    {
+        unsigned int tap = s - rows_->first[y];
+
+        if (tap >= rows_->offsets[y + 1] - rows_->offsets[y])
+        {
+            continue;
+        }
+
+        std::size_t open_row = y - next_output_row_;
+
+        while (open_sums_.size() <= open_row)
+        {
+            if (spare_sums_.empty())
+            {
+                spare_sums_.push_back(std::vector<std::uint32_t>(row_size));
+            }
+
+            open_sums_.push_back(std::move(spare_sums_.back()));
+            spare_sums_.pop_back();
+            std::fill(open_sums_.back().begin(), open_sums_.back().end(), 0);
+        }
+
+        peak_open_rows_ = std::max(peak_open_rows_, open_sums_.size());
+
+        kernel.add_weighted_row(row, rows_->weights[rows_->offsets[y] + tap], open_sums_[open_row].data(), row_size);
+    }
+
+    // Rows whose last tap was this one are done.
+    while (next_output_row_ < output_height_
+           && rows_->first[next_output_row_] + (rows_->offsets[next_output_row_ + 1] - rows_->offsets[next_output_row_]) <= s + 1)
+    {
+        reduce_columns(open_sums_.front().data(), *columns_, output_width_, channels_, output_buffer_.data());
+        output_row_(next_output_row_, output_buffer_.data());
+
+        spare_sums_.push_back(std::move(open_sums_.front()));
+        open_sums_.pop_front();
+        ++next_output_row_;
+    }
+}
+
+std::size_t StreamingResampler::get_peak_state_bytes() const
+{
+    return peak_open_rows_ * source_width_ * channels_ * sizeof(std::uint32_t) + output_buffer_.size();
+}
@@ -0,0 +1,83 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC target("avx2")
+
+#include <cstddef>
+#include <cstdint>
+
+#include <immintrin.h>
+
+// Row primitives of the area downscale, 32 bytes per step.
+
+void area_add_row_avx2(const unsigned char* row, std::uint16_t* sums, std::size_t size)
+{
+    std::size_t i = 0;
+
+    for (; i + 32 <= size; i += 32)
+    {
+        for (unsigned int half = 0; half < 2; ++half)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i + half * 16));
+            __m256i* destination = reinterpret_cast<__m256i*>(sums + i + half * 16);
+
+            _mm256_storeu_si256(destination, _mm256_add_epi16(_mm256_loadu_si256(destination),
+                                                              _mm256_cvtepu8_epi16(bytes)));
+        }
+    }
+
+    for (; i < size; ++i)
+    {
+        sums[i] += row[i];
+    }
+}
+
+void area_add_weighted_row_avx2(const unsigned char* row, std::uint32_t weight, std::uint32_t* sums, std::size_t size)
+{
+    const __m256i weights = _mm256_set1_epi16(static_cast<short>(weight));
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m256i words = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)));
+
+        // Full 32-bit products of 16-bit lanes. The unpacks work inside 128-bit lanes,
+        // the permutes put the products back in order.
+        __m256i low = _mm256_mullo_epi16(words, weights);
+        __m256i high = _mm256_mulhi_epu16(words, weights);
+        __m256i unpacked_low = _mm256_unpacklo_epi16(low, high);
+        __m256i unpacked_high = _mm256_unpackhi_epi16(low, high);
+
+        __m256i* first = reinterpret_cast<__m256i*>(sums + i);
+        __m256i* second = reinterpret_cast<__m256i*>(sums + i + 8);
+
+        _mm256_storeu_si256(first, _mm256_add_epi32(_mm256_loadu_si256(first),
+                                                    _mm256_permute2x128_si256(unpacked_low, unpacked_high, 0x20)));
+        _mm256_storeu_si256(second, _mm256_add_epi32(_mm256_loadu_si256(second),
+                                                     _mm256_permute2x128_si256(unpacked_low, unpacked_high, 0x31)));
+    }
+
+    for (; i < size; ++i)
+    {
+        sums[i] += row[i] * weight;
+    }
+}
+
+void area_add_shifted_avx2(const std::uint16_t* values, std::size_t shift, std::uint16_t* sums, std::size_t size)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m256i* destination = reinterpret_cast<__m256i*>(sums + i);
+        __m256i shifted = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + shift));
+
+        _mm256_storeu_si256(destination, _mm256_add_epi16(_mm256_loadu_si256(destination), shifted));
+    }
+
+    for (; i < size; ++i)
+    {
+        sums[i] += values[i + shift];
+    }
+}
+
+#endif
@@ -0,0 +1,81 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC target("sse2")
+
+#include <cstddef>
+#include <cstdint>
+
+#include <emmintrin.h>
+
+// Row primitives of the area downscale, 16 bytes per step.
+
+void area_add_row_sse2(const unsigned char* row, std::uint16_t* sums, std::size_t size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i* low = reinterpret_cast<__m128i*>(sums + i);
+        __m128i* high = reinterpret_cast<__m128i*>(sums + i + 8);
+
+        _mm_storeu_si128(low, _mm_add_epi16(_mm_loadu_si128(low), _mm_unpacklo_epi8(bytes, zero)));
+        _mm_storeu_si128(high, _mm_add_epi16(_mm_loadu_si128(high), _mm_unpackhi_epi8(bytes, zero)));
+    }
+
+    for (; i < size; ++i)
+    {
+        sums[i] += row[i];
+    }
+}
+
+void area_add_weighted_row_sse2(const unsigned char* row, std::uint32_t weight, std::uint32_t* sums, std::size_t size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights = _mm_set1_epi16(static_cast<short>(weight));
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i words[] = { _mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero) };
+
+        for (unsigned int half = 0; half < 2; ++half)
+        {
+            // Full 32-bit products of 16-bit lanes: low and high halves interleaved.
+            __m128i low = _mm_mullo_epi16(words[half], weights);
+            __m128i high = _mm_mulhi_epu16(words[half], weights);
+            __m128i* first = reinterpret_cast<__m128i*>(sums + i + half * 8);
+            __m128i* second = reinterpret_cast<__m128i*>(sums + i + half * 8 + 4);
+
+            _mm_storeu_si128(first, _mm_add_epi32(_mm_loadu_si128(first), _mm_unpacklo_epi16(low, high)));
+            _mm_storeu_si128(second, _mm_add_epi32(_mm_loadu_si128(second), _mm_unpackhi_epi16(low, high)));
+        }
+    }
+
+    for (; i < size; ++i)
+    {
+        sums[i] += row[i] * weight;
+    }
+}
+
+void area_add_shifted_sse2(const std::uint16_t* values, std::size_t shift, std::uint16_t* sums, std::size_t size)
+{
+    std::size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        __m128i* destination = reinterpret_cast<__m128i*>(sums + i);
+        __m128i shifted = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + shift));
+
+        _mm_storeu_si128(destination, _mm_add_epi16(_mm_loadu_si128(destination), shifted));
+    }
+
+    for (; i < size; ++i)
+    {
+        sums[i] += values[i + shift];
+    }
+}
+
+#endif
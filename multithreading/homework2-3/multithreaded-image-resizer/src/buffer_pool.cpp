@@ -0,0 +1,272 @@
+#include <vector>
+#include <mutex>
+#include <new>
+#include <cstddef>
+
+#include <opencv2/opencv.hpp>
+
+#include "include/buffer_pool.h"
+
+namespace
+{
+    // Smallest bucket is 4KB, smaller buffers are rounded up to it.
+    const unsigned int MIN_BUCKET = 12;
+    const unsigned int BUCKETS_NUMBER = 64;
+
+    // Free blocks kept per bucket and free headers kept overall, enough for every thread
+    // to hold a few images of each size.
+    const std::size_t MAX_FREE_BLOCKS = 16;
+    const std::size_t MAX_FREE_HEADERS = 256;
+
+    // A few full-size images; one 50MP BGR buffer takes a 256MB bucket alone.
+    const std::size_t DEFAULT_MAX_FREE_BYTES = std::size_t(512) << 20;
+
+    unsigned int get_bucket(std::size_t size)
+    {
+        unsigned int bucket = MIN_BUCKET;
+
+        while ((std::size_t(1) << bucket) < size)
+        {
+            ++bucket;
+        }
+
+        return bucket;
+    }
+}
+
+BufferPool::BufferPool() :
+    free_blocks_(BUCKETS_NUMBER),
+    allocations_number_(0),
+    reuses_number_(0),
+    free_bytes_(0),
+    max_free_bytes_(DEFAULT_MAX_FREE_BYTES)
+{
+    // Reserved up front, so returning a buffer never allocates.
+    for (auto& blocks : free_blocks_)
+    {
+        blocks.reserve(MAX_FREE_BLOCKS);
+    }
+
+    free_headers_.reserve(MAX_FREE_HEADERS);
+}
+
+BufferPool::~BufferPool()
+{
+    trim();
+
+    for (void* header : free_headers_)
+    {
+        ::operator delete(header);
+    }
+}
+
+cv::Mat BufferPool::make_image(int rows, int cols, int type)
+{
+    cv::Mat image = make_empty_image();
+    image.create(rows, cols, type);
+
+    return image;
+}
+
+cv::Mat BufferPool::make_empty_image()
+{
+    cv::Mat image;
+    image.allocator = this;
+
+    return image;
+}
+
+std::size_t BufferPool::get_allocations_number() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return allocations_number_;
+}
+
+std::size_t BufferPool::get_reuses_number() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return reuses_number_;
+}
+
+std::size_t BufferPool::get_free_bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return free_bytes_;
+}
+
+void BufferPool::set_max_free_bytes(std::size_t max_free_bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    max_free_bytes_ = max_free_bytes;
+    trim_to(max_free_bytes_);
+}
+
+std::size_t BufferPool::get_max_free_bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return max_free_bytes_;
+}
+
+void BufferPool::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    trim_to(0);
+}
+
+void BufferPool::trim_to(std::size_t max_free_bytes) const
+{
+    for (unsigned int bucket = BUCKETS_NUMBER; bucket-- > 0 && free_bytes_ > max_free_bytes; )
+    {
+        std::vector<void*>& blocks = free_blocks_[bucket];
+
+        while (!blocks.empty() && free_bytes_ > max_free_bytes)
+        {
+            cv::fastFree(blocks.back());
+            blocks.pop_back();
+            free_bytes_ -= std::size_t(1) << bucket;
+        }
+    }
+}
+
+cv::UMatData* BufferPool::allocate(int dims, const int* sizes, int type, void* data, size_t* step, int /* flags */,
+                                   cv::UMatUsageFlags /* usage_flags */) const
+{
+    // Steps and total size as cv::Mat's standard allocator computes them.
+    std::size_t total = CV_ELEM_SIZE(type);
+
+    for (int i = dims - 1; i >= 0; --i)
+    {
+        if (step != nullptr)
+        {
+            if (data != nullptr && step[i] != CV_AUTOSTEP)
+            {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            }
+            else
+            {
+                step[i] = total;
+            }
+        }
+
+        total *= sizes[i];
+    }
+
+    void* block = data;
+    void* header = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (block == nullptr)
+        {
+            std::vector<void*>& blocks = free_blocks_[get_bucket(total)];
+
+            if (!blocks.empty())
+            {
+                block = blocks.back();
+                blocks.pop_back();
+                free_bytes_ -= std::size_t(1) << get_bucket(total);
+                ++reuses_number_;
+            }
+            else
+            {
+                ++allocations_number_;
+            }
+        }
+
+        if (!free_headers_.empty())
+        {
+            header = free_headers_.back();
+            free_headers_.pop_back();
+        }
+        else
+        {
+            ++allocations_number_;
+        }
+    }
+
+    // Heap work outside the lock.
+    if (block == nullptr)
+    {
+        block = cv::fastMalloc(std::size_t(1) << get_bucket(total));
+    }
+
+    if (header == nullptr)
+    {
+        header = ::operator new(sizeof(cv::UMatData));
+    }
+
+    cv::UMatData* u = new (header) cv::UMatData(this);
+    u->data = u->origdata = static_cast<unsigned char*>(block);
+    u->size = total;
+
+    if (data != nullptr)
+    {
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+    }
+
+    return u;
+}
+
+bool BufferPool::allocate(cv::UMatData* data, int /* access_flags */, cv::UMatUsageFlags /* usage_flags */) const
+{
+    return data != nullptr;
+}
+
+void BufferPool::deallocate(cv::UMatData* data) const
+{
+    if (data == nullptr)
+    {
+        return;
+    }
+
+    CV_Assert(data->urefcount == 0);
+    CV_Assert(data->refcount == 0);
+
+    void* block = (data->flags & cv::UMatData::USER_ALLOCATED) ? nullptr : data->origdata;
+    unsigned int bucket = get_bucket(data->size);
+
+    data->~UMatData();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (block != nullptr && free_blocks_[bucket].size() < MAX_FREE_BLOCKS
+            && free_bytes_ + (std::size_t(1) << bucket) <= max_free_bytes_)
+        {
+            free_blocks_[bucket].push_back(block);
+            free_bytes_ += std::size_t(1) << bucket;
+            block = nullptr;
+        }
+
+        if (free_headers_.size() < MAX_FREE_HEADERS)
+        {
+            free_headers_.push_back(data);
+            data = nullptr;
+        }
+    }
+
+    if (block != nullptr)
+    {
+        cv::fastFree(block);
+    }
+
+    if (data != nullptr)
+    {
+        ::operator delete(data);
+    }
+}
+
+BufferPool& get_buffer_pool()
+{
+    static BufferPool* pool = new BufferPool();
+
+    return *pool;
+}
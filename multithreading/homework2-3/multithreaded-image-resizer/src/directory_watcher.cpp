@@ -0,0 +1,471 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <exception>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include "include/mapped_file.h"
+#include "include/image_resize.h"
+#include "include/result_manifest.h"
+#include "include/resizer_stats.h"
+#include "include/streaming_resize.h"
+#include "include/directory_watcher.h"
+
+namespace
+{
+    // A batch is closed when no event came for COALESCE_MS, when it is MAX_BATCH_DELAY_MS old
+    // or when it has MAX_BATCH_SIZE images, whichever is first.
+    const int COALESCE_MS = 100;
+    const int MAX_BATCH_DELAY_MS = 1000;
+    const std::size_t MAX_BATCH_SIZE = 256;
+
+    const uint32_t WATCH_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+    // JPEGs whose decode would take more are resized in strips, so a few of them at once
+    // do not take all the memory.
+    const std::uint64_t MAX_DECODED_BYTES = std::uint64_t(256) << 20;
+
+    // Input buffers of the workers bigger than this are freed after use instead of kept.
+    const std::size_t MAX_KEPT_INPUT_BYTES = std::size_t(64) << 20;
+
+    // First read of a file when looking for its JPEG header, doubled while the header is cut off.
+    const std::size_t HEADER_READ_BYTES = std::size_t(64) << 10;
+
+    // Size of the shrink-on-load decode of the image for the target.
+    std::uint64_t get_decoded_bytes(const JpegInfo& info, const ResizeSpec& spec)
+    {
+        unsigned int factor = 1;
+
+        switch (get_reduced_read_flag(info, spec))
+        {
+        case cv::IMREAD_REDUCED_COLOR_8:
+            factor = 8;
+            break;
+        case cv::IMREAD_REDUCED_COLOR_4:
+            factor = 4;
+            break;
+        case cv::IMREAD_REDUCED_COLOR_2:
+            factor = 2;
+            break;
+        }
+
+        return std::uint64_t((info.width + factor - 1) / factor) * ((info.height + factor - 1) / factor) * 3;
+    }
+
+    // Start of the file into bytes, up to its JPEG frame header. False if the file can not be read,
+    // is not a JPEG or has no frame header.
+    bool read_jpeg_header(const std::string& path, std::vector<unsigned char>& bytes, JpegInfo& info)
+    {
+        for (std::size_t size = HEADER_READ_BYTES; ; size *= 2)
+        {
+            if (!read_file(path, bytes, size))
+            {
+                return false;
+            }
+
+            if (read_jpeg_info(ByteSpan(bytes.data(), bytes.size()), info))
+            {
+                return true;
+            }
+
+            // Not a JPEG, or a broken header in the whole file.
+            if (bytes.size() < 2 || bytes[0] != 0xFF || bytes[1] != 0xD8 || bytes.size() < size)
+            {
+                return false;
+            }
+        }
+    }
+
+    enum class WaitResult
+    {
+        events,
+        timeout,
+        stopped,
+        failed
+    };
+
+    bool write_file(const std::string& path, const std::vector<unsigned char>& bytes)
+    {
+        StageTimer timer(Stage::write);
+
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        output.close();
+
+        if (!output)
+        {
+            std::remove(path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    WaitResult wait_for_events(int inotify_fd, int stop_fd, int timeout_ms)
+    {
+        pollfd fds[2] = { { inotify_fd, POLLIN, 0 }, { stop_fd, POLLIN, 0 } };
+        int ready;
+
+        // Interrupted by a signal: its handler may have called stop(), polled again to see it.
+        do
+        {
+            ready = poll(fds, 2, timeout_ms);
+        }
+        while (ready < 0 && errno == EINTR);
+
+        if (ready < 0)
+        {
+            return WaitResult::failed;
+        }
+
+        if (fds[1].revents != 0)
+        {
+            return WaitResult::stopped;
+        }
+
+        return ready > 0 ? WaitResult::events : WaitResult::timeout;
+    }
+}
+
+DirectoryWatcher::DirectoryWatcher(const std::string& input_dir, const std::string& output_dir, const ResizeSpec& spec,
+                                   unsigned int threads_number) :
+    input_dir_(input_dir),
+    output_dir_(output_dir),
+    spec_(spec),
+    parameters_("watch:" + std::to_string(spec.width) + "x" + std::to_string(spec.height) + ":"
+                + std::to_string(spec.interpolation)),
+    pool_(std::max(threads_number, 1u)),
+    inotify_fd_(-1),
+    resized_number_(0),
+    failed_number_(0)
+{
+    if (pipe2(stop_pipe_, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        stop_pipe_[0] = stop_pipe_[1] = -1;
+    }
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    for (int fd : { inotify_fd_, stop_pipe_[0], stop_pipe_[1] })
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+bool DirectoryWatcher::run()
+{
+    boost::system::error_code error;
+    boost::filesystem::create_directories(output_dir_, error);
+
+    if (stop_pipe_[0] < 0 || !boost::filesystem::is_directory(input_dir_) || !boost::filesystem::is_directory(output_dir_))
+    {
+        std::cout << "Failed to use directories: " << input_dir_ << ", " << output_dir_ << std::endl;
+        return false;
+    }
+
+    // Outputs written into the watched directory would be picked up as inputs.
+    if (boost::filesystem::equivalent(input_dir_, output_dir_, error))
+    {
+        std::cout << "Input and output directories must differ: " << input_dir_ << std::endl;
+        return false;
+    }
+
+    if (inotify_fd_ < 0)
+    {
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+
+    if (inotify_fd_ < 0 || inotify_add_watch(inotify_fd_, input_dir_.c_str(), WATCH_EVENTS) < 0)
+    {
+        std::cout << "Failed to watch directory: " << input_dir_ << std::endl;
+        return false;
+    }
+
+    manifest_.load(boost::filesystem::path(output_dir_ + "/" + ResultManifest::FILE_NAME).string());
+
+    std::cout << "Watching " << input_dir_ << " with " << pool_.get_threads_number() << " threads." << std::endl;
+
+    // The watch is set up before the scan, so images arriving during the scan are not missed.
+    bool is_rescan_needed = true;
+
+    for (;;)
+    {
+        std::set<std::string> names;
+
+        if (!is_rescan_needed)
+        {
+            WaitResult result = wait_for_events(inotify_fd_, stop_pipe_[0], -1);
+
+            if (result == WaitResult::stopped)
+            {
+                return true;
+            }
+
+            if (result == WaitResult::failed || !collect_batch(names, is_rescan_needed))
+            {
+                std::cout << "Lost watch of directory: " << input_dir_ << std::endl;
+                return false;
+            }
+        }
+
+        // Events were dropped, only a full scan knows what changed.
+        if (is_rescan_needed)
+        {
+            names.clear();
+            scan_input_dir(names);
+            is_rescan_needed = false;
+        }
+
+        process_batch(names);
+    }
+}
+
+void DirectoryWatcher::stop()
+{
+    char byte = 0;
+    ssize_t written = write(stop_pipe_[1], &byte, 1);
+    (void)written;  // A full pipe already wakes the watcher.
+}
+
+bool DirectoryWatcher::is_image_name(const std::string& name) const
+{
+    // Hidden files are usually temporaries of writers that rename them when done.
+    return !name.empty() && name[0] != '.' && boost::filesystem::path(name).extension() == JPG_EXTENSION;
+}
+
+std::string DirectoryWatcher::get_output_path(const std::string& name) const
+{
+    return boost::filesystem::path(output_dir_ + "/output_" + name).string();
+}
+
+void DirectoryWatcher::scan_input_dir(std::set<std::string>& names) const
+{
+    boost::system::error_code error;
+
+    for (boost::filesystem::directory_iterator file(input_dir_, error), end; !error && file != end; file.increment(error))
+    {
+        std::string name = file->path().filename().string();
+
+        if (is_image_name(name) && boost::filesystem::is_regular_file(file->status()))
+        {
+            names.insert(name);
+        }
+    }
+}
+
+bool DirectoryWatcher::collect_batch(std::set<std::string>& names, bool& is_rescan_needed)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (;;)
+    {
+        alignas(inotify_event) char buffer[4096];
+        ssize_t size;
+
+        while ((size = read(inotify_fd_, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* position = buffer; position < buffer + size; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+                position += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    is_rescan_needed = true;
+                }
+                else if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+                {
+                    return false;
+                }
+                else if (event->len > 0 && is_image_name(event->name))
+                {
+                    names.insert(event->name);
+                }
+            }
+        }
+
+        if (size < 0 && errno != EAGAIN && errno != EINTR)
+        {
+            return false;
+        }
+
+        int elapsed_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+        if (is_rescan_needed || names.size() >= MAX_BATCH_SIZE || elapsed_ms >= MAX_BATCH_DELAY_MS)
+        {
+            return true;
+        }
+
+        // Stop is seen by the next wait of run().
+        WaitResult result = wait_for_events(inotify_fd_, stop_pipe_[0],
+                                            std::min(COALESCE_MS, MAX_BATCH_DELAY_MS - elapsed_ms));
+
+        if (result == WaitResult::failed)
+        {
+            return false;
+        }
+
+        if (result != WaitResult::events)
+        {
+            return true;
+        }
+    }
+}
+
+void DirectoryWatcher::process_batch(const std::set<std::string>& names)
+{
+    if (names.empty())
+    {
+        return;
+    }
+
+    std::chrono::high_resolution_clock::time_point batch_start = std::chrono::high_resolution_clock::now();
+
+    // The manifest is used by this thread only, the workers just resize.
+    std::vector<std::string> input_paths;
+    std::vector<std::string> output_paths;
+    std::size_t up_to_date_number = 0;
+
+    for (const std::string& name : names)
+    {
+        std::string input_path = boost::filesystem::path(input_dir_ + "/" + name).string();
+        std::string output_path = get_output_path(name);
+
+        if (manifest_.is_up_to_date(input_path, parameters_, output_path))
+        {
+            ++up_to_date_number;
+        }
+        else
+        {
+            input_paths.push_back(input_path);
+            output_paths.push_back(output_path);
+        }
+    }
+
+    std::vector<char> results(input_paths.size(), 0);
+
+    for (std::size_t i = 0; i < input_paths.size(); ++i)
+    {
+        pool_.submit([this, i, &input_paths, &output_paths, &results]
+        {
+            // An exception escaping a pool task would terminate the daemon.
+            try
+            {
+                results[i] = resize_file(input_paths[i], spec_, output_paths[i]);
+            }
+            catch (const std::exception& error)
+            {
+                std::cerr << "Error resizing " << input_paths[i] << ": " << error.what() << std::endl;
+                results[i] = 0;
+            }
+        });
+    }
+
+    pool_.wait();
+
+    std::size_t batch_resized_number = 0;
+
+    for (std::size_t i = 0; i < input_paths.size(); ++i)
+    {
+        if (results[i])
+        {
+            manifest_.record(input_paths[i], parameters_, output_paths[i]);
+            ++batch_resized_number;
+        }
+        else
+        {
+            std::cout << "Failed to resize: " << input_paths[i] << std::endl;
+        }
+    }
+
+    resized_number_ += batch_resized_number;
+    failed_number_ += input_paths.size() - batch_resized_number;
+
+    if (batch_resized_number > 0 && !manifest_.save())
+    {
+        std::cout << "Failed to save manifest of: " << output_dir_ << std::endl;
+    }
+
+    std::chrono::high_resolution_clock::time_point batch_finish = std::chrono::high_resolution_clock::now();
+
+    auto batch_duration = std::chrono::duration_cast<std::chrono::microseconds>(batch_finish - batch_start).count();
+    std::cout << "Batch of " << names.size() << " images: " << batch_resized_number << " resized, "
+              << up_to_date_number << " up to date, " << input_paths.size() - batch_resized_number << " failed in "
+              << batch_duration << " microseconds." << std::endl;
+}
+
+bool DirectoryWatcher::resize_file(const std::string& input_path, const ResizeSpec& spec,
+                                   const std::string& output_path)
+{
+    // Input and encoded output buffers of the worker thread, kept for its next image.
+    thread_local std::vector<unsigned char> input;
+    thread_local std::vector<unsigned char> encoded;
+
+    bool is_streamed;
+    bool is_read;
+
+    {
+        // Read, not mapped: a writer truncating the file meanwhile would make a mapping fault with SIGBUS.
+        // Only the header is read before deciding, so JPEGs resized in strips are never read whole.
+        StageTimer timer(Stage::read);
+        JpegInfo info;
+
+        is_streamed = read_jpeg_header(input_path, input, info) && get_decoded_bytes(info, spec) > MAX_DECODED_BYTES;
+
+        // Whole file for the decoder, its start again from the page cache.
+        is_read = is_streamed || read_file(input_path, input);
+    }
+
+    if (!is_read)
+    {
+        return false;
+    }
+
+    // Written aside and renamed, so readers of the output directory never see a partial image.
+    std::string temporary_path = output_path + ".tmp";
+    bool is_written;
+
+    if (is_streamed)
+    {
+        // Decoded from the file with stdio reads, not mapped either. EXIF orientation is not applied.
+        is_written = resize_jpeg_streaming(input_path, temporary_path, spec);
+    }
+    else
+    {
+        is_written = resize_image(ByteSpan(input.data(), input.size()), spec,
+                                  boost::filesystem::path(output_path).extension().string(), encoded)
+                     && write_file(temporary_path, encoded);
+    }
+
+    if (input.capacity() > MAX_KEPT_INPUT_BYTES)
+    {
+        std::vector<unsigned char>().swap(input);
+    }
+
+    if (!is_written || std::rename(temporary_path.c_str(), output_path.c_str()) != 0)
+    {
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+
+    return true;
+}
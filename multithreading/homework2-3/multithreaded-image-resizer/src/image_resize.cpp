@@ -0,0 +1,621 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "include/thread_pool.h"
+#include "include/mapped_file.h"
+#include "include/buffer_pool.h"
+#include "include/resample_coefficients.h"
+#include "include/image_resize.h"
+#include "include/area_downscale.h"
+#include "include/resizer_stats.h"
+
+namespace
+{
+    // Input rows below which an extra band costs more than it saves.
+    const unsigned int MIN_BAND_ROWS = 64;
+
+    const unsigned int REDUCED_READ_FACTORS[] = { 8, 4, 2 };
+
+    // Limit of set_resize_threads_number, 0 for none.
+    std::atomic<unsigned int> resize_threads_limit(0);
+
+    unsigned int get_big_endian(const unsigned char* bytes, unsigned int size)
+    {
+        unsigned int value = 0;
+
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            value = (value << 8) | bytes[i];
+        }
+
+        return value;
+    }
+
+    unsigned int get_little_endian(const unsigned char* bytes, unsigned int size)
+    {
+        unsigned int value = 0;
+
+        for (unsigned int i = size; i > 0; --i)
+        {
+            value = (value << 8) | bytes[i - 1];
+        }
+
+        return value;
+    }
+
+    // Orientation tag of an APP1 Exif segment, 1 (as stored) when there is none.
+    unsigned int get_exif_orientation(ByteSpan segment)
+    {
+        const unsigned int TIFF_OFFSET = 6;  // After "Exif\0\0".
+        const unsigned int ORIENTATION_TAG = 0x0112;
+
+        if (segment.size < TIFF_OFFSET + 8 || std::memcmp(segment.data, "Exif", 4) != 0)
+        {
+            return 1;
+        }
+
+        const unsigned char* tiff = segment.data + TIFF_OFFSET;
+        std::size_t tiff_size = segment.size - TIFF_OFFSET;
+
+        bool is_big_endian = tiff[0] == 'M';
+        auto get = [is_big_endian](const unsigned char* bytes, unsigned int size)
+        {
+            return is_big_endian ? get_big_endian(bytes, size) : get_little_endian(bytes, size);
+        };
+
+        std::size_t ifd_offset = get(tiff + 4, 4);
+
+        if (ifd_offset + 2 > tiff_size)
+        {
+            return 1;
+        }
+
+        unsigned int entries_number = get(tiff + ifd_offset, 2);
+
+        for (unsigned int i = 0; i < entries_number; ++i)
+        {
+            std::size_t entry = ifd_offset + 2 + i * 12;
+
+            if (entry + 12 > tiff_size)
+            {
+                break;
+            }
+
+            if (get(tiff + entry, 2) == ORIENTATION_TAG)
+            {
+                return get(tiff + entry + 8, 2);
+            }
+        }
+
+        return 1;
+    }
+
+    // Parts (bands, sizes, ...) of one call. Pool tasks may start after the call returned,
+    // so they share it by pointer.
+    struct ParallelState
+    {
+        std::function<void(unsigned int)> process;
+        unsigned int parts_number;
+
+        std::atomic<unsigned int> next_part;
+
+        std::mutex mutex;
+        std::condition_variable parts_finished;
+        unsigned int finished_parts;
+        std::exception_ptr error;
+    };
+
+    // Takes parts until none is left. Parts are claimed, not assigned,
+    // so the caller alone finishes the job when every pool thread is busy.
+    void process_parts(ParallelState& state)
+    {
+        for (unsigned int part = state.next_part++; part < state.parts_number; part = state.next_part++)
+        {
+            std::exception_ptr error;
+
+            try
+            {
+                state.process(part);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            if (error && !state.error)
+            {
+                state.error = error;
+            }
+
+            if (++state.finished_parts == state.parts_number)
+            {
+                state.parts_finished.notify_all();
+            }
+        }
+    }
+
+    // process(0) .. process(parts_number - 1) on the calling thread and the shared pool.
+    void run_parallel(unsigned int parts_number, std::function<void(unsigned int)> process)
+    {
+        std::shared_ptr<ParallelState> state(new ParallelState());
+        state->process = std::move(process);
+        state->parts_number = parts_number;
+        state->next_part = 0;
+        state->finished_parts = 0;
+
+        ThreadPool& pool = get_resize_pool();
+
+        for (unsigned int i = 1; i < parts_number; ++i)
+        {
+            pool.submit([state] { process_parts(*state); });
+        }
+
+        process_parts(*state);
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->parts_finished.wait(lock, [&state] { return state->finished_parts == state->parts_number; });
+
+        if (state->error)
+        {
+            std::rethrow_exception(state->error);
+        }
+    }
+}
+
+ResizeSpec::ResizeSpec(unsigned int width, unsigned int height, int interpolation, ResizeEngine engine) :
+    width(width),
+    height(height),
+    interpolation(interpolation),
+    engine(engine)
+{
+}
+
+cv::Mat resize_image(const cv::Mat& source, const ResizeSpec& spec)
+{
+    if (source.empty() || spec.width == 0 || spec.height == 0)
+    {
+        return cv::Mat();
+    }
+
+    StageTimer timer(Stage::resize);
+
+    if (spec.engine == ResizeEngine::resample && source.depth() == CV_8U)
+    {
+        if (spec.interpolation == cv::INTER_LINEAR)
+        {
+            return resample_image(source, spec.width, spec.height, ResampleFilter::linear);
+        }
+
+        if (spec.interpolation == cv::INTER_AREA)
+        {
+            return resample_image(source, spec.width, spec.height, ResampleFilter::area);
+        }
+    }
+
+    cv::Mat output_image = get_buffer_pool().make_image(spec.height, spec.width, source.type());
+
+    // One call over all rows, which OpenCV itself runs in parallel with whole-image coordinates.
+    cv::resize(source, output_image, output_image.size(), 0, 0, spec.interpolation);
+
+    return output_image;
+}
+
+cv::Mat resize_image(const std::string& source_path, const ResizeSpec& spec)
+{
+    cv::Mat source = read_image_for_resize(source_path, spec);
+
+    if (source.empty())
+    {
+        return cv::Mat();
+    }
+
+    return resize_image(source, spec);
+}
+
+cv::Mat resize_image(ByteSpan encoded, const ResizeSpec& spec)
+{
+    cv::Mat source = decode_image_for_resize(encoded, spec);
+
+    if (source.empty())
+    {
+        return cv::Mat();
+    }
+
+    return resize_image(source, spec);
+}
+
+bool resize_image(ByteSpan encoded, const ResizeSpec& spec, const std::string& extension,
+                  std::vector<unsigned char>& output)
+{
+    cv::Mat output_image = resize_image(encoded, spec);
+
+    return !output_image.empty() && encode_image(output_image, extension, output);
+}
+
+bool resize_image_file(const std::string& source_path, const std::string& output_path, const ResizeSpec& spec)
+{
+    cv::Mat output_image = resize_image(source_path, spec);
+
+    return !output_image.empty() && write_image(output_path, output_image);
+}
+
+std::vector<cv::Mat> resize_image_pyramid(const cv::Mat& source, const std::vector<ResizeSpec>& specs)
+{
+    std::vector<cv::Mat> output_images(specs.size());
+
+    if (source.empty() || specs.empty())
+    {
+        return output_images;
+    }
+
+    unsigned int min_width = specs[0].width;
+    unsigned int min_height = specs[0].height;
+
+    for (auto& spec : specs)
+    {
+        min_width = std::min(min_width, spec.width);
+        min_height = std::min(min_height, spec.height);
+    }
+
+    // Halving levels, area-averaged, down to the smallest target. Every level costs a quarter
+    // of the previous one, so all of them together cost a third of the first.
+    std::vector<cv::Mat> levels(1, source);
+
+    for (;;)
+    {
+        const cv::Mat& level = levels.back();
+        ResizeSpec half((level.cols + 1) / 2, (level.rows + 1) / 2, cv::INTER_AREA);
+
+        if (half.width < min_width || half.height < min_height || level.cols < 2 || level.rows < 2)
+        {
+            break;
+        }
+
+        levels.push_back(resize_image(level, half));
+    }
+
+    // Every size from the smallest level still at least as big, the sizes in parallel.
+    run_parallel(static_cast<unsigned int>(specs.size()), [&specs, &levels, &output_images](unsigned int i)
+    {
+        std::size_t level = 0;
+
+        while (level + 1 < levels.size() && static_cast<unsigned int>(levels[level + 1].cols) >= specs[i].width
+               && static_cast<unsigned int>(levels[level + 1].rows) >= specs[i].height)
+        {
+            ++level;
+        }
+
+        output_images[i] = resize_image(levels[level], specs[i]);
+    });
+
+    return output_images;
+}
+
+std::vector<cv::Mat> resize_image_pyramid(ByteSpan encoded, const std::vector<ResizeSpec>& specs)
+{
+    ResizeSpec largest(0, 0);
+
+    for (auto& spec : specs)
+    {
+        largest.width = std::max(largest.width, spec.width);
+        largest.height = std::max(largest.height, spec.height);
+    }
+
+    // One decode, shrunk on load only as far as the largest size allows.
+    return resize_image_pyramid(decode_image_for_resize(encoded, largest), specs);
+}
+
+bool resize_image_files(const std::string& source_path, const std::vector<ResizeSpec>& specs,
+                        const std::vector<std::string>& output_paths)
+{
+    if (specs.size() != output_paths.size())
+    {
+        return false;
+    }
+
+    MappedFile file;
+    bool is_open;
+
+    {
+        StageTimer timer(Stage::read);
+        is_open = file.open(source_path);
+    }
+
+    if (!is_open)
+    {
+        return false;
+    }
+
+    std::vector<cv::Mat> output_images = resize_image_pyramid(file.get_bytes(), specs);
+
+    // Encoding is as slow as resizing, so it runs in parallel too.
+    std::atomic<bool> is_saved(true);
+
+    run_parallel(static_cast<unsigned int>(specs.size()), [&output_images, &output_paths, &is_saved](unsigned int i)
+    {
+        if (output_images[i].empty() || !write_image(output_paths[i], output_images[i]))
+        {
+            is_saved = false;
+        }
+    });
+
+    return is_saved;
+}
+
+bool read_jpeg_info(ByteSpan encoded, JpegInfo& info)
+{
+    const unsigned char* bytes = encoded.data;
+    const unsigned char* end = encoded.data + encoded.size;
+
+    if (encoded.size < 2 || bytes[0] != 0xFF || bytes[1] != 0xD8)
+    {
+        return false;
+    }
+
+    bytes += 2;
+
+    unsigned int orientation = 1;
+
+    // Segments up to the frame header: marker, big-endian length (counting itself), payload.
+    while (end - bytes >= 2)
+    {
+        if (bytes[0] != 0xFF)
+        {
+            return false;
+        }
+
+        unsigned char marker = bytes[1];
+
+        if (marker == 0xFF)
+        {
+            ++bytes;  // Fill byte.
+            continue;
+        }
+
+        bytes += 2;
+
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+        {
+            continue;  // No payload.
+        }
+
+        if (marker == 0xD9 || marker == 0xDA || end - bytes < 2)
+        {
+            return false;  // Image data without a frame header.
+        }
+
+        std::size_t length = get_big_endian(bytes, 2);
+
+        if (length < 2 || static_cast<std::size_t>(end - bytes) < length)
+        {
+            return false;
+        }
+
+        ByteSpan segment(bytes + 2, length - 2);
+        bytes += length;
+
+        // SOF0..SOF15 except DHT (C4), JPG (C8) and DAC (CC).
+        bool is_frame_header = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+
+        if (marker == 0xE1)
+        {
+            orientation = get_exif_orientation(segment);
+        }
+        else if (is_frame_header)
+        {
+            if (segment.size < 5)
+            {
+                return false;
+            }
+
+            info.height = get_big_endian(segment.data + 1, 2);
+            info.width = get_big_endian(segment.data + 3, 2);
+            info.transposed = orientation >= 5 && orientation <= 8;  // Rotated by 90 or 270 degrees.
+
+            return info.width != 0 && info.height != 0;
+        }
+    }
+
+    return false;
+}
+
+bool read_jpeg_info(const std::string& path, JpegInfo& info)
+{
+    // Only the header pages are actually read.
+    MappedFile file;
+
+    return file.open(path) && read_jpeg_info(file.get_bytes(), info);
+}
+
+int get_reduced_read_flag(const JpegInfo& info, const ResizeSpec& spec)
+{
+    unsigned int width = info.transposed ? info.height : info.width;
+    unsigned int height = info.transposed ? info.width : info.height;
+
+    for (unsigned int factor : REDUCED_READ_FACTORS)
+    {
+        // libjpeg rounds the scaled size up.
+        if ((width + factor - 1) / factor >= spec.width && (height + factor - 1) / factor >= spec.height)
+        {
+            switch (factor)
+            {
+            case 8:
+                return cv::IMREAD_REDUCED_COLOR_8;
+            case 4:
+                return cv::IMREAD_REDUCED_COLOR_4;
+            default:
+                return cv::IMREAD_REDUCED_COLOR_2;
+            }
+        }
+    }
+
+    return cv::IMREAD_COLOR;
+}
+
+cv::Mat decode_image(ByteSpan encoded, int flags)
+{
+    if (encoded.size == 0)
+    {
+        return cv::Mat();
+    }
+
+    StageTimer timer(Stage::decode);
+    get_resizer_stats().add_bytes_in(encoded.size);
+
+    // Header over the caller's bytes, nothing is copied.
+    cv::Mat buffer(1, static_cast<int>(encoded.size), CV_8UC1, const_cast<unsigned char*>(encoded.data));
+    cv::Mat image = get_buffer_pool().make_empty_image();
+
+    // Decoded straight into the pooled buffer, empty on failure.
+    cv::imdecode(buffer, flags, &image);
+
+    return image;
+}
+
+cv::Mat decode_image_for_resize(ByteSpan encoded, const ResizeSpec& spec)
+{
+    if (encoded.size == 0)
+    {
+        return cv::Mat();
+    }
+
+    JpegInfo info;
+    int flags = read_jpeg_info(encoded, info) ? get_reduced_read_flag(info, spec) : cv::IMREAD_COLOR;
+
+    return decode_image(encoded, flags);
+}
+
+cv::Mat read_image_for_resize(const std::string& path, const ResizeSpec& spec)
+{
+    MappedFile file;
+    bool is_open;
+
+    {
+        StageTimer timer(Stage::read);
+        is_open = file.open(path);
+    }
+
+    if (!is_open)
+    {
+        return cv::Mat();
+    }
+
+    return decode_image_for_resize(file.get_bytes(), spec);
+}
+
+bool encode_image(const cv::Mat& image, const std::string& extension, std::vector<unsigned char>& output)
+{
+    StageTimer timer(Stage::encode);
+
+    if (!cv::imencode(extension, image, output))
+    {
+        return false;
+    }
+
+    get_resizer_stats().add_bytes_out(output.size());
+
+    return true;
+}
+
+bool write_image(const std::string& path, const cv::Mat& image)
+{
+    std::size_t dot = path.rfind('.');
+
+    // Encoded output of the calling thread, its capacity kept for the next image.
+    thread_local std::vector<unsigned char> encoded;
+
+    if (dot == std::string::npos || !encode_image(image, path.substr(dot), encoded))
+    {
+        return false;
+    }
+
+    StageTimer timer(Stage::write);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    file.close();
+
+    return static_cast<bool>(file);
+}
+
+cv::Mat resample_image(const cv::Mat& source, unsigned int width, unsigned int height, ResampleFilter filter)
+{
+    if (source.empty() || source.depth() != CV_8U || width == 0 || height == 0)
+    {
+        return cv::Mat();
+    }
+
+    cv::Mat output_image = get_buffer_pool().make_image(height, width, source.type());
+
+    unsigned int channels = source.channels();
+    ConstPixelView input { source.ptr(), static_cast<unsigned int>(source.cols), static_cast<unsigned int>(source.rows),
+                           source.step[0], channels };
+    PixelView output { output_image.ptr(), width, height, output_image.step[0], channels };
+
+    // Output rows only depend on their own input rows, so any split is exact.
+    unsigned int rows = std::max(static_cast<unsigned int>(source.rows), height);
+    unsigned int bands_number = std::min(get_resize_threads_number(), std::max(1u, rows / MIN_BAND_ROWS));
+    bands_number = std::min(bands_number, height);
+
+    run_parallel(bands_number, [&input, &output, filter, height, bands_number](unsigned int band)
+    {
+        resample(input, output, filter, height * band / bands_number, height * (band + 1) / bands_number);
+    });
+
+    return output_image;
+}
+
+cv::Mat area_downscale_image(const cv::Mat& source, unsigned int width, unsigned int height)
+{
+    if (width > static_cast<unsigned int>(source.cols) || height > static_cast<unsigned int>(source.rows))
+    {
+        return cv::Mat();
+    }
+
+    return resample_image(source, width, height, ResampleFilter::area);
+}
+
+ThreadPool& get_resize_pool()
+{
+    // Initialized once even with concurrent first calls.
+    static ThreadPool pool(std::thread::hardware_concurrency());
+
+    return pool;
+}
+
+void set_resize_threads_number(unsigned int threads_number)
+{
+    resize_threads_limit = threads_number;
+}
+
+unsigned int get_resize_threads_number()
+{
+    unsigned int threads_number = get_resize_pool().get_threads_number() + 1;
+    unsigned int limit = resize_threads_limit;
+
+    return limit > 0 ? std::min(limit, threads_number) : threads_number;
+}
+
+unsigned int get_bands_number(unsigned int input_height, unsigned int output_height, unsigned int max_bands)
+{
+    unsigned int rows = std::max(input_height, output_height);
+    unsigned int bands_number = std::min(std::max(max_bands, 1u), std::max(rows / MIN_BAND_ROWS, 1u));
+
+    return std::max(std::min(bands_number, output_height), 1u);
+}
@@ -0,0 +1,322 @@
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstddef>
+
+#include <jpeglib.h>
+
+#include "include/jpeg_stream.h"
+
+// libjpeg reports fatal errors through error_exit, which must not return: it jumps back
+// to the setjmp of the call in progress. Functions with a setjmp keep no objects with destructors.
+
+namespace
+{
+    // Rows handed to libjpeg per call.
+    const unsigned int ROWS_PER_CALL = 16;
+
+    struct ErrorManager
+    {
+        jpeg_error_mgr manager;
+        std::jmp_buf jump;
+    };
+
+    void exit_on_error(j_common_ptr info)
+    {
+        std::longjmp(reinterpret_cast<ErrorManager*>(info->err)->jump, 1);
+    }
+
+    // Warnings about corrupt data are not fatal and not printed.
+    void skip_message(j_common_ptr)
+    {
+    }
+
+    jpeg_error_mgr* init_error_manager(ErrorManager& error)
+    {
+        jpeg_error_mgr* manager = jpeg_std_error(&error.manager);
+        manager->error_exit = exit_on_error;
+        manager->output_message = skip_message;
+
+        return manager;
+    }
+}
+
+struct JpegStripReader::State
+{
+    jpeg_decompress_struct info;
+    ErrorManager error;
+    std::FILE* file;
+    bool is_created;
+    bool is_started;
+};
+
+JpegStripReader::JpegStripReader()
+{
+}
+
+JpegStripReader::~JpegStripReader()
+{
+    close();
+}
+
+bool JpegStripReader::open(const std::string& path)
+{
+    close();
+
+    state_.reset(new State());
+    state_->file = std::fopen(path.c_str(), "rb");
+    state_->is_created = false;
+    state_->is_started = false;
+
+    if (state_->file == nullptr)
+    {
+        state_.reset();
+        return false;
+    }
+
+    state_->info.err = init_error_manager(state_->error);
+
+    if (setjmp(state_->error.jump))
+    {
+        close();
+        return false;
+    }
+
+    jpeg_create_decompress(&state_->info);
+    state_->is_created = true;
+
+    jpeg_stdio_src(&state_->info, state_->file);
+    jpeg_read_header(&state_->info, TRUE);
+
+    return true;
+}
+
+unsigned int JpegStripReader::get_image_width() const
+{
+    return state_ ? state_->info.image_width : 0;
+}
+
+unsigned int JpegStripReader::get_image_height() const
+{
+    return state_ ? state_->info.image_height : 0;
+}
+
+bool JpegStripReader::start(unsigned int scale_denominator)
+{
+    if (!state_ || state_->is_started)
+    {
+        return false;
+    }
+
+    if (setjmp(state_->error.jump))
+    {
+        close();
+        return false;
+    }
+
+    state_->info.scale_num = 1;
+    state_->info.scale_denom = scale_denominator;
+    state_->info.out_color_space = state_->info.jpeg_color_space == JCS_GRAYSCALE ? JCS_GRAYSCALE : JCS_RGB;
+
+    jpeg_start_decompress(&state_->info);
+    state_->is_started = true;
+
+    return true;
+}
+
+unsigned int JpegStripReader::get_width() const
+{
+    return state_ && state_->is_started ? state_->info.output_width : 0;
+}
+
+unsigned int JpegStripReader::get_height() const
+{
+    return state_ && state_->is_started ? state_->info.output_height : 0;
+}
+
+unsigned int JpegStripReader::get_channels() const
+{
+    return state_ && state_->is_started ? state_->info.output_components : 0;
+}
+
+unsigned int JpegStripReader::read_rows(unsigned char* rows, std::size_t step, unsigned int max_rows)
+{
+    if (!state_ || !state_->is_started)
+    {
+        return 0;
+    }
+
+    if (setjmp(state_->error.jump))
+    {
+        close();
+        return 0;
+    }
+
+    jpeg_decompress_struct& info = state_->info;
+    unsigned int read_rows_number = 0;
+
+    while (read_rows_number < max_rows && info.output_scanline < info.output_height)
+    {
+        JSAMPROW pointers[ROWS_PER_CALL];
+        unsigned int rows_number = std::min(max_rows - read_rows_number, ROWS_PER_CALL);
+
+        for (unsigned int i = 0; i < rows_number; ++i)
+        {
+            pointers[i] = rows + (read_rows_number + i) * step;
+        }
+
+        read_rows_number += jpeg_read_scanlines(&info, pointers, rows_number);
+    }
+
+    return read_rows_number;
+}
+
+void JpegStripReader::close()
+{
+    if (!state_)
+    {
+        return;
+    }
+
+    // Destroying works at any stage and frees everything libjpeg holds.
+    if (state_->is_created)
+    {
+        jpeg_destroy_decompress(&state_->info);
+    }
+
+    std::fclose(state_->file);
+    state_.reset();
+}
+
+struct JpegRowWriter::State
+{
+    jpeg_compress_struct info;
+    ErrorManager error;
+    std::FILE* file;
+    bool is_failed;
+};
+
+JpegRowWriter::JpegRowWriter()
+{
+}
+
+JpegRowWriter::~JpegRowWriter()
+{
+    if (state_)
+    {
+        jpeg_destroy_compress(&state_->info);
+        std::fclose(state_->file);
+    }
+}
+
+bool JpegRowWriter::open(const std::string& path, unsigned int width, unsigned int height, unsigned int channels,
+                         int quality)
+{
+    if (state_ || (channels != 1 && channels != 3))
+    {
+        return false;
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    state_.reset(new State());
+    state_->file = file;
+    state_->is_failed = false;
+    state_->info.err = init_error_manager(state_->error);
+
+    jpeg_create_compress(&state_->info);
+
+    if (setjmp(state_->error.jump))
+    {
+        state_->is_failed = true;
+        return false;
+    }
+
+    jpeg_stdio_dest(&state_->info, state_->file);
+
+    state_->info.image_width = width;
+    state_->info.image_height = height;
+    state_->info.input_components = channels;
+    state_->info.in_color_space = channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
+
+    jpeg_set_defaults(&state_->info);
+    jpeg_set_quality(&state_->info, quality, TRUE);
+    jpeg_start_compress(&state_->info, TRUE);
+
+    return true;
+}
+
+bool JpegRowWriter::write_rows(const unsigned char* rows, std::size_t step, unsigned int rows_number)
+{
+    if (!state_ || state_->is_failed)
+    {
+        return false;
+    }
+
+    // libjpeg ignores rows past the image height and reports 0 written.
+    if (rows_number > state_->info.image_height - state_->info.next_scanline)
+    {
+        state_->is_failed = true;
+        return false;
+    }
+
+    if (setjmp(state_->error.jump))
+    {
+        state_->is_failed = true;
+        return false;
+    }
+
+    for (unsigned int written = 0; written < rows_number; )
+    {
+        JSAMPROW pointers[ROWS_PER_CALL];
+        unsigned int batch = std::min(rows_number - written, ROWS_PER_CALL);
+
+        for (unsigned int i = 0; i < batch; ++i)
+        {
+            pointers[i] = const_cast<unsigned char*>(rows + (written + i) * step);
+        }
+
+        JDIMENSION batch_written = jpeg_write_scanlines(&state_->info, pointers, batch);
+
+        if (batch_written == 0)
+        {
+            state_->is_failed = true;
+            return false;
+        }
+
+        written += batch_written;
+    }
+
+    return true;
+}
+
+bool JpegRowWriter::finish()
+{
+    if (!state_ || state_->is_failed || state_->info.next_scanline != state_->info.image_height)
+    {
+        return false;
+    }
+
+    if (setjmp(state_->error.jump))
+    {
+        state_->is_failed = true;
+        return false;
+    }
+
+    jpeg_finish_compress(&state_->info);
+    jpeg_destroy_compress(&state_->info);
+
+    bool is_written = !std::ferror(state_->file);
+    is_written = std::fclose(state_->file) == 0 && is_written;
+
+    state_.reset();
+
+    return is_written;
+}
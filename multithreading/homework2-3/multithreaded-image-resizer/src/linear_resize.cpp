@@ -0,0 +1,184 @@
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include <opencv2/opencv.hpp>
+
+#include "include/linear_resize.h"
+
+namespace
+{
+    // INTER_RESIZE_COEF_BITS of OpenCV: weights in 1/2048.
+    const int WEIGHT_ONE = 1 << 11;
+
+    int clamp_row(int row, int rows)
+    {
+        return std::min(std::max(row, 0), rows - 1);
+    }
+}
+
+LinearResize::LinearResize(const cv::Mat& input_image, cv::Size output_size) :
+    input_image_(input_image),
+    output_size_(output_size),
+    channels_(input_image.channels()),
+    is_half_(false),
+    x_clamped_(0)
+{
+    if (!is_supported(input_image) || output_size.width <= 0 || output_size.height <= 0)
+    {
+        return;
+    }
+
+    // Same expressions as cv::resize, so the doubles and floats round the same way.
+    double scale_x = 1. / (static_cast<double>(output_size.width) / input_image.cols);
+    double scale_y = 1. / (static_cast<double>(output_size.height) / input_image.rows);
+
+    int integer_scale_x = cv::saturate_cast<int>(scale_x);
+    int integer_scale_y = cv::saturate_cast<int>(scale_y);
+
+    is_half_ = integer_scale_x == 2 && integer_scale_y == 2 && std::abs(scale_x - integer_scale_x) < DBL_EPSILON
+               && std::abs(scale_y - integer_scale_y) < DBL_EPSILON;
+
+    if (is_half_)
+    {
+        return;
+    }
+
+    int width = output_size.width * channels_;
+    x_clamped_ = width;
+
+    for (int x = 0; x < output_size.width; ++x)
+    {
+        float fraction = static_cast<float>((x + 0.5) * scale_x - 0.5);
+        int input_x = cvFloor(fraction);
+        fraction -= input_x;
+
+        if (input_x < 0)
+        {
+            fraction = 0;
+            input_x = 0;
+        }
+
+        if (input_x + 1 >= input_image.cols)
+        {
+            x_clamped_ = std::min(x_clamped_, x * channels_);
+            fraction = 0;
+            input_x = input_image.cols - 1;
+        }
+
+        short left_weight = cv::saturate_cast<short>((1.f - fraction) * WEIGHT_ONE);
+        short right_weight = cv::saturate_cast<short>(fraction * WEIGHT_ONE);
+
+        for (int channel = 0; channel < channels_; ++channel)
+        {
+            x_offsets_.push_back(input_x * channels_ + channel);
+            x_weights_.push_back(left_weight);
+            x_weights_.push_back(right_weight);
+        }
+    }
+
+    // Rows are clamped only when read, so the weights of border rows are kept as computed.
+    for (int y = 0; y < output_size.height; ++y)
+    {
+        float fraction = static_cast<float>((y + 0.5) * scale_y - 0.5);
+        int input_y = cvFloor(fraction);
+        fraction -= input_y;
+
+        y_offsets_.push_back(input_y);
+        y_weights_.push_back(cv::saturate_cast<short>((1.f - fraction) * WEIGHT_ONE));
+        y_weights_.push_back(cv::saturate_cast<short>(fraction * WEIGHT_ONE));
+    }
+}
+
+bool LinearResize::is_supported(const cv::Mat& input_image)
+{
+    return !input_image.empty() && input_image.depth() == CV_8U && input_image.channels() <= 4;
+}
+
+void LinearResize::resize_rows(unsigned int first_row, unsigned int last_row, cv::Mat& output_image) const
+{
+    if (is_half_)
+    {
+        average_rows(first_row, last_row, output_image);
+        return;
+    }
+
+    int width = output_size_.width * channels_;
+
+    // Horizontally resized input rows, kept while the next output rows still read them.
+    std::vector<int> buffers[2] = { std::vector<int>(width), std::vector<int>(width) };
+    int buffer_rows[2] = { -1, -1 };
+
+    for (unsigned int y = first_row; y < last_row; ++y)
+    {
+        int input_rows[2] = { clamp_row(y_offsets_[y], input_image_.rows), clamp_row(y_offsets_[y] + 1, input_image_.rows) };
+        const int* rows[2];
+
+        for (int k = 0; k < 2; ++k)
+        {
+            int buffer = buffer_rows[0] == input_rows[k] ? 0 : (buffer_rows[1] == input_rows[k] ? 1 : -1);
+
+            if (buffer < 0)
+            {
+                // The buffer that does not hold the other row.
+                buffer = buffer_rows[0] == input_rows[1 - k] ? 1 : 0;
+                resize_row_horizontally(input_rows[k], buffers[buffer].data());
+                buffer_rows[buffer] = input_rows[k];
+            }
+
+            rows[k] = buffers[buffer].data();
+        }
+
+        int upper_weight = y_weights_[2 * y];
+        int lower_weight = y_weights_[2 * y + 1];
+        unsigned char* output_row = output_image.ptr(y);
+
+        // As the 16-bit lanes of OpenCV's vertical pass, whose scalar loop does the same: both rows
+        // cut to 15 bits, multiplied keeping the high half, then rounded off the last 2 bits.
+        for (int x = 0; x < width; ++x)
+        {
+            int sum = (((rows[0][x] >> 4) * upper_weight) >> 16) + (((rows[1][x] >> 4) * lower_weight) >> 16);
+            output_row[x] = static_cast<unsigned char>((sum + 2) >> 2);
+        }
+    }
+}
+
+void LinearResize::resize_row_horizontally(int input_row, int* output_row) const
+{
+    const unsigned char* input = input_image_.ptr(input_row);
+    int width = output_size_.width * channels_;
+
+    for (int x = 0; x < x_clamped_; ++x)
+    {
+        int offset = x_offsets_[x];
+        output_row[x] = input[offset] * x_weights_[2 * x] + input[offset + channels_] * x_weights_[2 * x + 1];
+    }
+
+    for (int x = x_clamped_; x < width; ++x)
+    {
+        output_row[x] = input[x_offsets_[x]] * WEIGHT_ONE;
+    }
+}
+
+void LinearResize::average_rows(unsigned int first_row, unsigned int last_row, cv::Mat& output_image) const
+{
+    int width = output_size_.width * channels_;
+
+    for (unsigned int y = first_row; y < last_row; ++y)
+    {
+        const unsigned char* upper = input_image_.ptr(2 * y);
+        const unsigned char* lower = input_image_.ptr(2 * y + 1);
+        unsigned char* output_row = output_image.ptr(y);
+
+        for (int x = 0; x < width; ++x)
+        {
+            int offset = x / channels_ * 2 * channels_ + x % channels_;
+            int sum = upper[offset] + upper[offset + channels_] + lower[offset] + lower[offset + channels_];
+
+            // OpenCV has a rounding shift for 1, 3 and 4 channels and a float product for 2.
+            output_row[x] = channels_ == 2 ? cv::saturate_cast<unsigned char>(sum * 0.25f)
+                                           : static_cast<unsigned char>((sum + 2) >> 2);
+        }
+    }
+}
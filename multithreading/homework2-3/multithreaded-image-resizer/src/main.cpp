@@ -1,15 +1,222 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
 #include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <csignal>
+#include <cstdlib>
+#include <cstddef>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "include/image_resize.h"
+#include "include/buffer_pool.h"
+#include "include/area_downscale.h"
+#include "include/resample_coefficients.h"
+#include "include/streaming_resize.h"
+#include "include/jpeg_stream.h"
 #include "include/multithreaded_resizer.h"
+#include "include/directory_watcher.h"
+#include "include/resizer_stats.h"
 
-int main()
+namespace
 {
+    // Growth of the peak resident memory allowed to the streaming resize: a few full-width strips
+    // plus room for libjpeg and the allocator, far below the decoded image for big sides.
+    const unsigned int HUGE_TEST_BUDGET_STRIPS = 8;
+    const std::size_t HUGE_TEST_BUDGET_SLACK = std::size_t(16) << 20;
+
+    const unsigned int HUGE_TEST_OUTPUT_SIZE = 1000;
+
+    // The synthetic image's green channel is a vertical gradient, which any resize keeps.
+    // JPEG ringing at the rows where the checkerboard flips moves it by up to about 12.
+    const int HUGE_TEST_MAX_GREEN_ERROR = 16;
+
+    long get_peak_resident_kb()
+    {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        return usage.ru_maxrss;
+    }
+
+    // Current, not peak: the peak so far may be from the generation of the image.
+    long get_resident_kb()
+    {
+        std::ifstream statm("/proc/self/statm");
+        long size_pages = 0;
+        long resident_pages = 0;
+
+        if (!(statm >> size_pages >> resident_pages))
+        {
+            return get_peak_resident_kb();
+        }
+
+        return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    // Output of the huge image test read back: its size and the gradient of every row.
+    bool check_huge_output(const std::string& path, unsigned int width, unsigned int height)
+    {
+        JpegStripReader reader;
+
+        if (!reader.open(path) || !reader.start(1))
+        {
+            std::cerr << "Failed to read resized image: " << path << std::endl;
+            return false;
+        }
+
+        if (reader.get_width() != width || reader.get_height() != height || reader.get_channels() != 3)
+        {
+            std::cerr << "Resized image is " << reader.get_width() << "x" << reader.get_height() << "x"
+                      << reader.get_channels() << " instead of " << width << "x" << height << "x3." << std::endl;
+            return false;
+        }
+
+        std::vector<unsigned char> row(std::size_t(width) * 3);
+
+        for (unsigned int y = 0; y < height; ++y)
+        {
+            if (reader.read_rows(row.data(), row.size(), 1) != 1)
+            {
+                std::cerr << "Failed to read row " << y << " of resized image: " << path << std::endl;
+                return false;
+            }
+
+            int expected_green = static_cast<int>((y + 0.5) * 255 / height);
+            int green = row[std::size_t(width / 2) * 3 + 1];
+
+            if (std::abs(green - expected_green) > HUGE_TEST_MAX_GREEN_ERROR)
+            {
+                std::cerr << "Row " << y << " of resized image has green " << green << " instead of "
+                          << expected_green << "." << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Synthetic square JPEG of the given side made and resized in strips. Fails if the peak resident
+    // memory grew by more than a few strips, which shows that the decoded image was never held,
+    // or if the output has the wrong size or content. 30000 makes a 2.7GB image.
+    int run_huge_image_test(unsigned int size, const std::string& directory_path)
+    {
+        std::string huge_image_path = directory_path + "/huge_image.jpg";
+        std::string huge_output_image_path = directory_path + "/huge_output_image.jpg";
+
+        std::chrono::high_resolution_clock::time_point generation_start = std::chrono::high_resolution_clock::now();
+        bool is_generated = write_synthetic_jpeg(huge_image_path, size, size);
+        std::chrono::high_resolution_clock::time_point generation_finish = std::chrono::high_resolution_clock::now();
+
+        if (!is_generated)
+        {
+            std::cerr << "Failed to write synthetic image: " << huge_image_path << std::endl;
+            return 1;
+        }
+
+        auto generation_duration = std::chrono::duration_cast<std::chrono::microseconds>(generation_finish - generation_start).count();
+        std::cout << "Synthetic " << size << "x" << size << " image written in " << generation_duration << " microseconds, "
+                  << boost::filesystem::file_size(huge_image_path) << " bytes." << std::endl;
+
+        StreamingStats stats;
+        long start_resident_kb = get_resident_kb();
+
+        std::chrono::high_resolution_clock::time_point streaming_start = std::chrono::high_resolution_clock::now();
+        bool is_resized = resize_jpeg_streaming(huge_image_path, huge_output_image_path,
+                                                ResizeSpec(HUGE_TEST_OUTPUT_SIZE, HUGE_TEST_OUTPUT_SIZE, cv::INTER_AREA),
+                                                95, &stats);
+        std::chrono::high_resolution_clock::time_point streaming_finish = std::chrono::high_resolution_clock::now();
+
+        long peak_resident_kb = get_peak_resident_kb();
+
+        boost::filesystem::remove(huge_image_path);
+
+        if (!is_resized)
+        {
+            std::cerr << "Failed to resize image in strips: " << huge_image_path << std::endl;
+            return 1;
+        }
+
+        auto streaming_duration = std::chrono::duration_cast<std::chrono::microseconds>(streaming_finish - streaming_start).count();
+        std::cout << "Streaming resize duration: " << streaming_duration << " microseconds, decoded at "
+                  << stats.decoded_width << "x" << stats.decoded_height << ", strip buffers: " << stats.peak_buffer_bytes
+                  << " bytes, peak resident memory: " << peak_resident_kb << " KB, decoded image would be "
+                  << 3ull * size * size << " bytes." << std::endl;
+
+        // Full-width strips of the source, as if it were not scaled on decode.
+        std::size_t budget_bytes = HUGE_TEST_BUDGET_STRIPS * 3ull * size * STREAMING_STRIP_ROWS + HUGE_TEST_BUDGET_SLACK;
+        std::size_t growth_bytes = static_cast<std::size_t>(std::max(peak_resident_kb - start_resident_kb, 0l)) * 1024;
+
+        bool is_in_budget = growth_bytes <= budget_bytes;
+        bool is_checked = check_huge_output(huge_output_image_path, HUGE_TEST_OUTPUT_SIZE, HUGE_TEST_OUTPUT_SIZE);
+
+        if (!is_in_budget)
+        {
+            std::cerr << "Peak resident memory grew by " << growth_bytes << " bytes, over the budget of "
+                      << budget_bytes << " bytes." << std::endl;
+        }
+
+        return is_in_budget && is_checked ? 0 : 1;
+    }
+
+    DirectoryWatcher* running_watcher = nullptr;
+
+    void stop_watcher(int)
+    {
+        running_watcher->stop();
+    }
+
+    // Daemon mode: resizes images as they arrive in the input directory until SIGINT or SIGTERM.
+    int run_watcher(const std::string& input_images_dir_path, const std::string& output_images_dir_path,
+                    unsigned int output_width, unsigned int output_height)
+    {
+        DirectoryWatcher watcher(input_images_dir_path, output_images_dir_path, ResizeSpec(output_width, output_height),
+                                 MultithreadedResizer::get_cores_number());
+
+        // Snapshot for monitoring, replaced every 10 seconds.
+        StatsReporter reporter(output_images_dir_path + "/.resize_stats.json", 10000);
+
+        running_watcher = &watcher;
+        std::signal(SIGINT, stop_watcher);
+        std::signal(SIGTERM, stop_watcher);
+
+        bool is_watched = watcher.run();
+
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        running_watcher = nullptr;
+
+        std::cout << "Watcher stopped: " << watcher.get_resized_number() << " images resized, "
+                  << watcher.get_failed_number() << " failed." << std::endl;
+
+        return is_watched ? 0 : 1;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "--huge")
+    {
+        return run_huge_image_test(argc > 2 ? std::stoul(argv[2]) : 30000, "../multithreaded-image-resizer/test");
+    }
+
+    // --watch <input directory> <output directory> [<width> <height>]
+    if (argc > 3 && std::string(argv[1]) == "--watch")
+    {
+        return run_watcher(argv[2], argv[3], argc > 5 ? std::stoul(argv[4]) : 160, argc > 5 ? std::stoul(argv[5]) : 90);
+    }
+
     std::string input_image_path = "../multithreaded-image-resizer/test/input_image.jpg";
     std::string output_image_path = "../multithreaded-image-resizer/test/output_image.jpg";
 
@@ -39,6 +246,84 @@ int main()
     auto std_async_duration = std::chrono::duration_cast<std::chrono::microseconds>(std_async_finish - std_async_start).count();
     std::cout << "Multi-threaded (std::async) duration: " << std_async_duration << " microseconds." << std::endl;
 
+    std::chrono::high_resolution_clock::time_point bands_start = std::chrono::high_resolution_clock::now();
+    resizer.resize_image_bands(input_image_path, 160, 90, output_image_path);
+    std::chrono::high_resolution_clock::time_point bands_finish = std::chrono::high_resolution_clock::now();
+
+    auto bands_duration = std::chrono::duration_cast<std::chrono::microseconds>(bands_finish - bands_start).count();
+    std::cout << "Multi-threaded (bands) duration: " << bands_duration << " microseconds." << std::endl;
+
+    // The timed size, the exact half that cv::resize averages instead, odd sizes and an enlargement.
+    const cv::Size bands_check_sizes[] = { cv::Size(160, 90), cv::Size(960, 540), cv::Size(1001, 563), cv::Size(2500, 1407) };
+    double bands_difference = 0;
+
+    for (auto& size : bands_check_sizes)
+    {
+        cv::Mat bands_output_image = resizer.resize_image_bands(input_image_path, size.width, size.height, output_image_path);
+        cv::Mat single_thread_output_image = resizer.resize_image_single_thread(input_image_path, size.width, size.height,
+                                                                                output_image_path);
+
+        bands_difference = std::max(bands_difference, cv::norm(bands_output_image, single_thread_output_image, cv::NORM_INF));
+    }
+
+    std::cout << "Bands vs single-threaded max pixel difference: " << bands_difference << std::endl;
+
+    if (bands_difference != 0)
+    {
+        std::cerr << "Bands differ from the single-threaded cv::resize." << std::endl;
+        return 1;
+    }
+
+    std::chrono::high_resolution_clock::time_point streaming_start = std::chrono::high_resolution_clock::now();
+    resizer.resize_image_streaming(input_image_path, 160, 90, output_image_path);
+    std::chrono::high_resolution_clock::time_point streaming_finish = std::chrono::high_resolution_clock::now();
+
+    auto streaming_duration = std::chrono::duration_cast<std::chrono::microseconds>(streaming_finish - streaming_start).count();
+    std::cout << "Streaming (strips) duration: " << streaming_duration << " microseconds." << std::endl;
+
+    // Many request threads sharing the stateless API and its worker pool.
+    const unsigned int requests_number = 4 * MultithreadedResizer::get_cores_number();
+    cv::Mat input_image = cv::imread(input_image_path, CV_LOAD_IMAGE_COLOR);
+
+    std::chrono::high_resolution_clock::time_point stateless_start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> request_threads;
+
+    for (unsigned int i = 0; i < requests_number; ++i)
+    {
+        request_threads.push_back(std::thread([&input_image]
+        {
+            resize_image(input_image, ResizeSpec(160, 90));
+        }));
+    }
+
+    for (auto& thread : request_threads)
+    {
+        thread.join();
+    }
+
+    std::chrono::high_resolution_clock::time_point stateless_finish = std::chrono::high_resolution_clock::now();
+
+    auto stateless_duration = std::chrono::duration_cast<std::chrono::microseconds>(stateless_finish - stateless_start).count();
+    std::cout << "Stateless API duration of " << requests_number << " concurrent requests: " << stateless_duration << " microseconds." << std::endl;
+
+    // Same requests on the opt-in fixed-point kernel. Same geometry for every request,
+    // so all but the first lookups of each axis hit.
+    ResizeSpec resample_spec(160, 90, cv::INTER_LINEAR, ResizeEngine::resample);
+    cv::Mat resample_output_image;
+
+    for (unsigned int i = 0; i < requests_number; ++i)
+    {
+        resample_output_image = resize_image(input_image, resample_spec);
+    }
+
+    CoefficientCache& coefficient_cache = get_coefficient_cache();
+    std::cout << "Coefficient cache: " << coefficient_cache.get_hits() << " hits, " << coefficient_cache.get_misses()
+              << " misses, hit rate " << coefficient_cache.get_hit_rate() << "." << std::endl;
+
+    std::cout << "Fixed-point kernel vs cv::resize max pixel difference: "
+              << cv::norm(resample_output_image, resize_image(input_image, ResizeSpec(160, 90)), cv::NORM_INF) << std::endl;
+
     std::chrono::high_resolution_clock::time_point std_async_dir_start = std::chrono::high_resolution_clock::now();
     resizer.resize_images_std_async(input_images_dir_path, 160, 90, output_images_dir_path);
     std::chrono::high_resolution_clock::time_point std_async_dir_finish = std::chrono::high_resolution_clock::now();
@@ -46,5 +331,177 @@ int main()
     auto std_async_dir_duration = std::chrono::duration_cast<std::chrono::microseconds>(std_async_dir_finish - std_async_dir_start).count();
     std::cout << "Multi-threaded (std::async) duration of images directory processing: " << std_async_dir_duration << " microseconds." << std::endl;
 
+    // Nothing changed since the previous run, so every image is a result cache hit.
+    std::chrono::high_resolution_clock::time_point incremental_dir_start = std::chrono::high_resolution_clock::now();
+    resizer.resize_images_std_async(input_images_dir_path, 160, 90, output_images_dir_path);
+    std::chrono::high_resolution_clock::time_point incremental_dir_finish = std::chrono::high_resolution_clock::now();
+
+    auto incremental_dir_duration = std::chrono::duration_cast<std::chrono::microseconds>(incremental_dir_finish - incremental_dir_start).count();
+    std::cout << "Incremental re-run duration of unchanged images directory: " << incremental_dir_duration << " microseconds." << std::endl;
+
+    // Steady state: more passes over the same images take every pixel buffer from the pool.
+    // Only pixel buffers are counted, the decoders, encoders and tasks still allocate their own objects.
+    // The outputs are removed first, so the passes do not hit the result cache.
+    const unsigned int pool_passes = 3;
+
+    BufferPool& buffer_pool = get_buffer_pool();
+    std::size_t warm_allocations_number = buffer_pool.get_allocations_number();
+
+    for (unsigned int i = 0; i < pool_passes; ++i)
+    {
+        boost::filesystem::remove_all(output_images_dir_path);
+        resizer.resize_images_std_async(input_images_dir_path, 160, 90, output_images_dir_path);
+    }
+
+    std::cout << "Buffer pool pixel-buffer allocations: " << warm_allocations_number << " warming up, "
+              << buffer_pool.get_allocations_number() - warm_allocations_number << " in " << pool_passes
+              << " more passes, " << buffer_pool.get_reuses_number() << " reuses." << std::endl;
+
+    std::chrono::high_resolution_clock::time_point pipeline_dir_start = std::chrono::high_resolution_clock::now();
+    resizer.resize_images_pipeline(input_images_dir_path, 160, 90, output_images_dir_path);
+    std::chrono::high_resolution_clock::time_point pipeline_dir_finish = std::chrono::high_resolution_clock::now();
+
+    auto pipeline_dir_duration = std::chrono::duration_cast<std::chrono::microseconds>(pipeline_dir_finish - pipeline_dir_start).count();
+    std::cout << "Pipelined duration of images directory processing: " << pipeline_dir_duration << " microseconds." << std::endl;
+
+    // Shrink-on-load: full decode and resize vs reduced JPEG decode and resize of the same images.
+    const unsigned int decode_iterations = 5;
+
+    long long full_decode_duration = 0;
+    long long reduced_decode_duration = 0;
+    std::size_t full_decode_bytes = 0;
+    std::size_t reduced_decode_bytes = 0;
+
+    for (auto& file : boost::filesystem::directory_iterator(input_images_dir_path))
+    {
+        if (file.path().extension() != resizer.JPG_EXTENSION)
+        {
+            continue;
+        }
+
+        ResizeSpec spec(160, 90);
+
+        for (unsigned int i = 0; i < decode_iterations; ++i)
+        {
+            std::chrono::high_resolution_clock::time_point full_start = std::chrono::high_resolution_clock::now();
+            cv::Mat full_image = cv::imread(file.path().string(), CV_LOAD_IMAGE_COLOR);
+            cv::Mat full_output_image = resize_image(full_image, spec);
+            std::chrono::high_resolution_clock::time_point full_finish = std::chrono::high_resolution_clock::now();
+
+            std::chrono::high_resolution_clock::time_point reduced_start = std::chrono::high_resolution_clock::now();
+            cv::Mat reduced_image = read_image_for_resize(file.path().string(), spec);
+            cv::Mat reduced_output_image = resize_image(reduced_image, spec);
+            std::chrono::high_resolution_clock::time_point reduced_finish = std::chrono::high_resolution_clock::now();
+
+            full_decode_duration += std::chrono::duration_cast<std::chrono::microseconds>(full_finish - full_start).count();
+            reduced_decode_duration += std::chrono::duration_cast<std::chrono::microseconds>(reduced_finish - reduced_start).count();
+
+            full_decode_bytes = std::max(full_decode_bytes, full_image.total() * full_image.elemSize());
+            reduced_decode_bytes = std::max(reduced_decode_bytes, reduced_image.total() * reduced_image.elemSize());
+        }
+    }
+
+    std::cout << "Full decode and resize of images directory: " << full_decode_duration / decode_iterations
+              << " microseconds, biggest decoded image: " << full_decode_bytes << " bytes." << std::endl;
+    std::cout << "Shrink-on-load decode and resize of images directory: " << reduced_decode_duration / decode_iterations
+              << " microseconds, biggest decoded image: " << reduced_decode_bytes << " bytes." << std::endl;
+
+    // Encoded bytes in memory to encoded bytes in a reused buffer, no temp files.
+    std::ifstream input_file(input_image_path, std::ios::binary);
+    std::vector<unsigned char> encoded_input((std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>());
+    std::vector<unsigned char> encoded_output;
+
+    std::chrono::high_resolution_clock::time_point in_memory_start = std::chrono::high_resolution_clock::now();
+    bool is_encoded = resize_image(ByteSpan(encoded_input.data(), encoded_input.size()), ResizeSpec(160, 90), ".jpg", encoded_output);
+    std::chrono::high_resolution_clock::time_point in_memory_finish = std::chrono::high_resolution_clock::now();
+
+    auto in_memory_duration = std::chrono::duration_cast<std::chrono::microseconds>(in_memory_finish - in_memory_start).count();
+    std::cout << "In-memory resize duration: " << in_memory_duration << " microseconds, "
+              << (is_encoded ? encoded_output.size() : 0) << " encoded bytes." << std::endl;
+
+    // Thumbnail sizes: one decode and a pyramid vs a full single-threaded resize per size.
+    std::vector<ResizeSpec> thumbnail_specs = { ResizeSpec(1280, 720), ResizeSpec(640, 360), ResizeSpec(320, 180),
+                                                ResizeSpec(160, 90), ResizeSpec(80, 45) };
+    std::vector<std::string> thumbnail_paths;
+
+    for (auto& spec : thumbnail_specs)
+    {
+        thumbnail_paths.push_back("../multithreaded-image-resizer/test/output_image_" + std::to_string(spec.width) + "x"
+                                  + std::to_string(spec.height) + ".jpg");
+    }
+
+    std::chrono::high_resolution_clock::time_point thumbnails_single_start = std::chrono::high_resolution_clock::now();
+
+    for (std::size_t i = 0; i < thumbnail_specs.size(); ++i)
+    {
+        resizer.resize_image_single_thread(input_image_path, thumbnail_specs[i].width, thumbnail_specs[i].height, thumbnail_paths[i]);
+    }
+
+    std::chrono::high_resolution_clock::time_point thumbnails_single_finish = std::chrono::high_resolution_clock::now();
+
+    std::chrono::high_resolution_clock::time_point thumbnails_pyramid_start = std::chrono::high_resolution_clock::now();
+    resize_image_files(input_image_path, thumbnail_specs, thumbnail_paths);
+    std::chrono::high_resolution_clock::time_point thumbnails_pyramid_finish = std::chrono::high_resolution_clock::now();
+
+    auto thumbnails_single_duration = std::chrono::duration_cast<std::chrono::microseconds>(thumbnails_single_finish - thumbnails_single_start).count();
+    auto thumbnails_pyramid_duration = std::chrono::duration_cast<std::chrono::microseconds>(thumbnails_pyramid_finish - thumbnails_pyramid_start).count();
+
+    std::cout << "Single-threaded duration of " << thumbnail_specs.size() << " thumbnail sizes: " << thumbnails_single_duration << " microseconds." << std::endl;
+    std::cout << "Pyramid duration of " << thumbnail_specs.size() << " thumbnail sizes: " << thumbnails_pyramid_duration
+              << " microseconds, speedup: " << static_cast<double>(thumbnails_single_duration) / std::max<long long>(thumbnails_pyramid_duration, 1) << "x." << std::endl;
+
+    // Area downscale: cv::resize with INTER_AREA vs the fixed-point kernel, by reduction factor.
+    const unsigned int area_iterations = 5;
+    const unsigned int area_factors[] = { 2, 3, 4 };
+
+    std::vector<cv::Mat> area_images;
+
+    for (auto& file : boost::filesystem::directory_iterator(input_images_dir_path))
+    {
+        if (file.path().extension() == resizer.JPG_EXTENSION)
+        {
+            area_images.push_back(cv::imread(file.path().string(), CV_LOAD_IMAGE_COLOR));
+        }
+    }
+
+    std::cout << "Area downscale kernel: " << get_area_downscale_kernel_name() << "." << std::endl;
+
+    for (unsigned int factor : area_factors)
+    {
+        long long opencv_area_duration = 0;
+        long long kernel_area_duration = 0;
+        double area_difference = 0;
+
+        for (auto& image : area_images)
+        {
+            cv::Size area_size(image.cols / factor, image.rows / factor);
+            cv::Mat opencv_output_image;
+            cv::Mat kernel_output_image;
+
+            for (unsigned int i = 0; i < area_iterations; ++i)
+            {
+                std::chrono::high_resolution_clock::time_point opencv_area_start = std::chrono::high_resolution_clock::now();
+                cv::resize(image, opencv_output_image, area_size, 0, 0, cv::INTER_AREA);
+                std::chrono::high_resolution_clock::time_point opencv_area_finish = std::chrono::high_resolution_clock::now();
+
+                std::chrono::high_resolution_clock::time_point kernel_area_start = std::chrono::high_resolution_clock::now();
+                kernel_output_image = area_downscale_image(image, area_size.width, area_size.height);
+                std::chrono::high_resolution_clock::time_point kernel_area_finish = std::chrono::high_resolution_clock::now();
+
+                opencv_area_duration += std::chrono::duration_cast<std::chrono::microseconds>(opencv_area_finish - opencv_area_start).count();
+                kernel_area_duration += std::chrono::duration_cast<std::chrono::microseconds>(kernel_area_finish - kernel_area_start).count();
+            }
+
+            area_difference = std::max(area_difference, cv::norm(opencv_output_image, kernel_output_image, cv::NORM_INF));
+        }
+
+        std::cout << "Area downscale by " << factor << ": cv::resize " << opencv_area_duration / area_iterations
+                  << " microseconds, fixed-point kernel " << kernel_area_duration / area_iterations
+                  << " microseconds, max pixel difference: " << area_difference << "." << std::endl;
+    }
+
+    // Per-stage latencies, queue depths and worker utilization of everything above.
+    std::cout << "Stats: " << stats_to_json(get_stats()) << std::endl;
+
     return 0;
 }
@@ -0,0 +1,127 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "include/mapped_file.h"
+
+MappedFile::MappedFile() :
+    data_(nullptr),
+    size_(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_ = file_stat.st_size;
+
+    if (size_ != 0)
+    {
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data_ == MAP_FAILED)
+        {
+            data_ = nullptr;
+            size_ = 0;
+            ::close(fd);
+            return false;
+        }
+
+        // Decoders read the file once from start to end.
+        madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+
+    ::close(fd);  // The mapping keeps the file.
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_ != nullptr)
+    {
+        munmap(data_, size_);
+    }
+
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool read_file(const std::string& path, std::vector<unsigned char>& bytes, std::size_t max_size)
+{
+    bytes.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat file_stat;
+
+    // The size is only a hint, the file may grow or shrink while it is read.
+    std::size_t hint = fstat(fd, &file_stat) == 0 && file_stat.st_size > 0 ? file_stat.st_size + 1 : 4096;
+    bytes.resize(std::min(hint, max_size));
+
+    std::size_t size = 0;
+
+    while (size < max_size)
+    {
+        if (size == bytes.size())
+        {
+            bytes.resize(std::min(bytes.size() * 2, max_size));
+        }
+
+        ssize_t read_size = ::read(fd, bytes.data() + size, bytes.size() - size);
+
+        if (read_size > 0)
+        {
+            size += read_size;
+        }
+        else if (read_size == 0)
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            int read_error = errno;
+            ::close(fd);
+            bytes.clear();
+            errno = read_error;
+            return false;
+        }
+    }
+
+    ::close(fd);
+    bytes.resize(size);
+
+    return true;
+}
@@ -3,6 +3,12 @@
 #include <vector>
 #include <thread>
 #include <future>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 #include <boost/filesystem.hpp>
 
@@ -10,9 +16,167 @@
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "include/bounded_queue.h"
+#include "include/buffer_pool.h"
+#include "include/mapped_file.h"
+#include "include/image_resize.h"
+#include "include/linear_resize.h"
+#include "include/streaming_resize.h"
+#include "include/result_manifest.h"
+#include "include/resizer_stats.h"
 #include "include/multithreaded_resizer.h"
 
-MultithreadedResizer::MultithreadedResizer()
+namespace
+{
+    // Pipeline queue depths: file names are cheap, decoded images are not.
+    const std::size_t FILES_QUEUE_DEPTH = 1024;
+    const std::size_t IMAGES_PER_CONSUMER = 2;
+
+    const unsigned int MAX_SCANNERS = 4;
+
+    struct ImageJob
+    {
+        std::string input_path;
+        std::string output_path;
+        cv::Mat image;
+    };
+
+    // Directories waiting to be listed, shared by the scanner threads.
+    struct ScanState
+    {
+        std::mutex mutex;
+        std::condition_variable directory_available;
+
+        // Input directory and the output directory mirroring it.
+        std::vector<std::pair<boost::filesystem::path, boost::filesystem::path>> directories;
+        unsigned int pending_directories;  // Queued plus being listed.
+
+        boost::filesystem::path output_root;
+    };
+
+    // cv::Exception or std::bad_alloc of one image, which is then skipped like an image that fails to decode.
+    void report_error(const char* message, const std::string& path, const std::exception& error)
+    {
+        std::cerr << message << ": " << path << " (" << error.what() << ")" << std::endl;
+    }
+
+    void scan_directories(ScanState& state, const std::string& extension, BoundedQueue<ImageJob>& files)
+    {
+        for (;;)
+        {
+            std::pair<boost::filesystem::path, boost::filesystem::path> directory;
+
+            {
+                std::unique_lock<std::mutex> lock(state.mutex);
+
+                state.directory_available.wait(lock, [&state]
+                {
+                    return !state.directories.empty() || state.pending_directories == 0;
+                });
+
+                if (state.directories.empty())
+                {
+                    return;
+                }
+
+                directory = state.directories.back();
+                state.directories.pop_back();
+            }
+
+            bool is_output_dir_exists = false;
+            boost::system::error_code error;
+
+            for (boost::filesystem::directory_iterator it(directory.first, error), end; !error && it != end;
+                 it.increment(error))
+            {
+                const boost::filesystem::path& path = it->path();
+
+                boost::system::error_code path_error;
+                boost::filesystem::file_status status = it->symlink_status(path_error);
+
+                // Links to directories are not followed: a link to an ancestor would recurse forever.
+                if (boost::filesystem::is_symlink(status) && boost::filesystem::is_directory(path, path_error))
+                {
+                    continue;
+                }
+
+                if (boost::filesystem::is_directory(status))
+                {
+                    // Output tree inside the input one must not be fed back.
+                    if (boost::filesystem::equivalent(path, state.output_root, path_error))
+                    {
+                        continue;
+                    }
+
+                    std::lock_guard<std::mutex> lock(state.mutex);
+
+                    state.directories.push_back(std::make_pair(path, directory.second / path.filename()));
+                    ++state.pending_directories;
+                    state.directory_available.notify_one();
+                }
+                else if (path.extension() == extension)
+                {
+                    if (!is_output_dir_exists)
+                    {
+                        boost::filesystem::create_directories(directory.second, path_error);
+                        is_output_dir_exists = boost::filesystem::is_directory(directory.second, path_error);
+
+                        if (!is_output_dir_exists)
+                        {
+                            std::cerr << "Failed to create directory: " << directory.second.string() << std::endl;
+                            break;
+                        }
+                    }
+
+                    ImageJob job;
+                    job.input_path = path.string();
+                    job.output_path = (directory.second / ("output_" + path.filename().string())).string();
+
+                    if (files.push(std::move(job)))
+                    {
+                        get_resizer_stats().add_queue_depth(StatsQueue::pipeline_files, 1);
+                    }
+                }
+            }
+
+            if (error)
+            {
+                std::cerr << "Failed to list directory: " << directory.first.string() << std::endl;
+            }
+
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            if (--state.pending_directories == 0)
+            {
+                state.directory_available.notify_all();
+            }
+        }
+    }
+
+    // Runs threads_number copies of stage, the last one to finish closes the output queue (if any).
+    template <typename Stage>
+    void start_stage(unsigned int threads_number, Stage stage, BoundedQueue<ImageJob>* output,
+                     std::vector<std::thread>& threads)
+    {
+        std::shared_ptr<std::atomic<unsigned int>> running(new std::atomic<unsigned int>(threads_number));
+
+        for (unsigned int i = 0; i < threads_number; ++i)
+        {
+            threads.push_back(std::thread([stage, running, output]
+            {
+                stage();
+
+                if (--*running == 0 && output != nullptr)
+                {
+                    output->close();
+                }
+            }));
+        }
+    }
+}
+
+MultithreadedResizer::MultithreadedResizer() :
+    threads_number_(std::max(get_cores_number(), 1u))
 {
 }
 
@@ -28,18 +192,18 @@ cv::Mat MultithreadedResizer::resize_image_single_thread(const std::string& inpu
     // Read input image.
     read_image(input_image_path);
 
-    //std::chrono::high_resolution_clock::time_point st_start = std::chrono::high_resolution_clock::now();
-
-    output_image_width_ = output_width;
-    output_image_height_ = output_height;
+    {
+        StageTimer timer(Stage::resize);
 
-    cv::resize(input_image_, output_image_, cv::Size(output_image_width_, output_image_height_));
+        output_image_width_ = output_width;
+        output_image_height_ = output_height;
 
-    //std::chrono::high_resolution_clock::time_point st_finish = std::chrono::high_resolution_clock::now();
+        // Fresh pooled buffer, images returned by earlier calls stay intact.
+        output_image_ = get_buffer_pool().make_image(output_image_height_, output_image_width_, input_image_.type());
 
-    //auto st_duration = std::chrono::duration_cast<std::chrono::microseconds>(st_finish - st_start).count();
+        cv::resize(input_image_, output_image_, cv::Size(output_image_width_, output_image_height_));
 
-    //std::cout << "Single-threaded duration: " << st_duration << " microseconds." << std::endl;
+    }
 
     save_image(output_image_, output_image_path);
 
@@ -54,48 +218,41 @@ cv::Mat MultithreadedResizer::resize_image_std_thread(const std::string& input_i
     // Read input image.
     read_image(input_image_path);
 
-    //std::chrono::high_resolution_clock::time_point mt_start = std::chrono::high_resolution_clock::now();
+    {
+        StageTimer timer(Stage::resize);
 
-    output_image_width_ = output_width;
-    output_image_height_ = output_height;
+        output_image_width_ = output_width;
+        output_image_height_ = output_height;
 
-    // Make the output image ready to write.
-    output_image_ = cv::Mat(output_image_height_, output_image_width_, CV_8UC3, cv::Scalar(0, 0, 0));
+        // The tiles cover the whole output image, no need to clear it.
+        output_image_ = get_buffer_pool().make_image(output_image_height_, output_image_width_, input_image_.type());
 
-    columns_to_split_ = get_cores_number() / 2;
-    rows_to_split_ = get_cores_number() / 2;
+        columns_to_split_ = get_tile_grid_size();
+        rows_to_split_ = get_tile_grid_size();
 
-    chunk_width_ = input_image_width_ / columns_to_split_;
-    chunk_height_ = input_image_height_ / rows_to_split_;
+        chunk_width_ = input_image_width_ / columns_to_split_;
+        chunk_height_ = input_image_height_ / rows_to_split_;
 
-    unsigned int new_chunk_width = output_image_width_ / columns_to_split_;
-    unsigned int new_chunk_height = output_image_height_ / rows_to_split_;
+        std::vector<std::thread> threads;
+        threads.reserve(columns_to_split_ * rows_to_split_);
 
-    std::vector<std::thread> threads;
-    threads.reserve(columns_to_split_ * rows_to_split_);
+        for (unsigned int y = 0; y < rows_to_split_; ++y)
+        {
+            for (unsigned int x = 0; x < columns_to_split_; ++x)
+            {
+                threads.push_back(std::thread(&MultithreadedResizer::process_chunk,
+                                              std::cref(input_image_), columns_to_split_, rows_to_split_, x, y,
+                                              std::ref(output_image_)));
+            }
+        }
 
-    for (unsigned int y = 0; y < rows_to_split_; ++y)
-    {
-        for (unsigned int x = 0; x < columns_to_split_; ++x)
+        for (auto& thread : threads)
         {
-            threads.push_back(std::thread(&MultithreadedResizer::process_chunk,
-                                          std::ref(input_image_), chunk_width_, chunk_height_,
-                                          new_chunk_width, new_chunk_height, x, y,
-                                          std::ref(output_image_)));
+            thread.join();
         }
-    }
 
-    for (auto& thread : threads)
-    {
-        thread.join();
     }
 
-    //std::chrono::high_resolution_clock::time_point mt_finish = std::chrono::high_resolution_clock::now();
-
-    //auto mt_duration = std::chrono::duration_cast<std::chrono::microseconds>(mt_finish - mt_start).count();
-
-    //std::cout << "Multi-threaded (std::thread) implementation duration: " << mt_duration << " microseconds." << std::endl;
-
     save_image(output_image_, output_image_path);
 
     return output_image_;
@@ -107,60 +264,123 @@ cv::Mat MultithreadedResizer::resize_image_std_async(const std::string& input_im
     // Read input image.
     read_image(input_image_path);
 
-    //std::chrono::high_resolution_clock::time_point async_start = std::chrono::high_resolution_clock::now();
-
-    output_image_width_ = output_width;
-    output_image_height_ = output_height;
+    {
+        StageTimer timer(Stage::resize);
 
-    // Make the output image ready to write.
-    output_image_ = cv::Mat(output_image_height_, output_image_width_, CV_8UC3, cv::Scalar(0, 0, 0));
+        output_image_width_ = output_width;
+        output_image_height_ = output_height;
 
-    columns_to_split_ = get_cores_number() / 2;
-    rows_to_split_ = get_cores_number() / 2;
+        // The tiles cover the whole output image, no need to clear it.
+        output_image_ = get_buffer_pool().make_image(output_image_height_, output_image_width_, input_image_.type());
 
-    chunk_width_ = input_image_width_ / columns_to_split_;
-    chunk_height_ = input_image_height_ / rows_to_split_;
+        columns_to_split_ = get_tile_grid_size();
+        rows_to_split_ = get_tile_grid_size();
 
-    unsigned int new_chunk_width = output_image_width_ / columns_to_split_;
-    unsigned int new_chunk_height = output_image_height_ / rows_to_split_;
+        chunk_width_ = input_image_width_ / columns_to_split_;
+        chunk_height_ = input_image_height_ / rows_to_split_;
 
-    std::vector<std::future<void>> results;
+        std::vector<std::future<void>> results;
 
-    for (unsigned int y = 0; y < rows_to_split_; ++y)
-    {
-        for (unsigned int x = 0; x < columns_to_split_; ++x)
+        for (unsigned int y = 0; y < rows_to_split_; ++y)
         {
-            std::future<void> result = std::async(std::launch::async, &MultithreadedResizer::process_chunk,
-                                                  std::ref(input_image_), chunk_width_, chunk_height_,
-                                                  new_chunk_width, new_chunk_height, x, y,
-                                                  std::ref(output_image_));
+            for (unsigned int x = 0; x < columns_to_split_; ++x)
+            {
+                std::future<void> result = std::async(std::launch::async, &MultithreadedResizer::process_chunk,
+                                                      std::cref(input_image_), columns_to_split_, rows_to_split_, x, y,
+                                                      std::ref(output_image_));
 
-            results.push_back(std::move(result));
+                results.push_back(std::move(result));
+            }
+        }
+
+        for (auto& result : results)
+        {
+            result.get();
         }
+
     }
 
-    for (auto& result : results)
+    // Save image.
+    save_image(output_image_, output_image_path);
+
+    return output_image_;
+}
+
+cv::Mat MultithreadedResizer::resize_image_bands(const std::string& input_image_path, unsigned int output_width,
+                                                 unsigned int output_height, const std::string& output_image_path)
+{
+    // Read input image.
+    read_image(input_image_path);
+
+    output_image_width_ = output_width;
+    output_image_height_ = output_height;
+
     {
-        result.get();
-    }
+        StageTimer timer(Stage::resize);
 
-    //std::chrono::high_resolution_clock::time_point async_finish = std::chrono::high_resolution_clock::now();
+        // Every band is written completely, no need to clear the output image.
+        output_image_ = get_buffer_pool().make_image(output_image_height_, output_image_width_, input_image_.type());
 
-    //auto async_duration = std::chrono::duration_cast<std::chrono::microseconds>(async_finish - async_start).count();
+        if (LinearResize::is_supported(input_image_))
+        {
+            // Every row comes from the whole-image tables, so any split gives the image of one cv::resize.
+            LinearResize resize(input_image_, output_image_.size());
 
-    //std::cout << "Multi-threaded (std::async) implementation duration: " << async_duration << " microseconds." << std::endl;
+            unsigned int bands_number = get_bands_number(input_image_height_, output_image_height_, threads_number_);
+            std::vector<std::thread> threads;
+
+            for (unsigned int band = 0; band < bands_number; ++band)
+            {
+                threads.push_back(std::thread(&LinearResize::resize_rows, &resize,
+                                              output_image_height_ * band / bands_number,
+                                              output_image_height_ * (band + 1) / bands_number,
+                                              std::ref(output_image_)));
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+        else
+        {
+            // One cv::resize, run in parallel over rows by OpenCV itself.
+            cv::resize(input_image_, output_image_, output_image_.size(), 0, 0, cv::INTER_LINEAR);
+        }
+    }
 
-    // Save image.
     save_image(output_image_, output_image_path);
 
     return output_image_;
 }
 
+bool MultithreadedResizer::resize_image_streaming(const std::string& input_image_path, unsigned int output_width,
+                                                  unsigned int output_height, const std::string& output_image_path)
+{
+    output_image_width_ = output_width;
+    output_image_height_ = output_height;
+
+    if (!resize_jpeg_streaming(input_image_path, output_image_path, ResizeSpec(output_width, output_height)))
+    {
+        std::cerr << "Failed to resize image in strips: " << input_image_path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
 void MultithreadedResizer::resize_images_std_async(const std::string& input_images_dir, unsigned int output_width,
                                                    unsigned int output_height, const std::string& output_images_dir)
 {
     bool is_output_dir_exists = boost::filesystem::exists(output_images_dir);
 
+    // Outputs of earlier runs are kept if their inputs and the parameters did not change.
+    std::string manifest_path = boost::filesystem::path(output_images_dir + "/" + ResultManifest::FILE_NAME).string();
+    std::string parameters = "std_async:" + std::to_string(output_width) + "x" + std::to_string(output_height);
+
+    ResultManifest manifest;
+    manifest.load(manifest_path);
+
     for (auto& file : boost::filesystem::directory_iterator(input_images_dir))
     {
         if (file.path().extension() == JPG_EXTENSION)
@@ -183,25 +403,170 @@ void MultithreadedResizer::resize_images_std_async(const std::string& input_imag
             std::string output_image_name = "output_" + file.path().filename().string();
             std::string output_image_path = boost::filesystem::path(output_images_dir + "/" + output_image_name).string();
 
+            if (manifest.is_up_to_date(file.path().string(), parameters, output_image_path))
+            {
+                continue;
+            }
+
             resize_image_std_async(file.path().string(), output_width, output_height, output_image_path);
+            manifest.record(file.path().string(), parameters, output_image_path);
         }
     }
+
+    if (is_output_dir_exists && !manifest.save())
+    {
+        std::cout << "Failed to save manifest: " << manifest_path << std::endl;
+    }
+
+    std::cout << "Result cache: " << manifest.get_hits() << " hits, " << manifest.get_misses() << " misses." << std::endl;
 }
 
-void MultithreadedResizer::process_chunk(cv::Mat& input_image, unsigned int chunk_width, unsigned int chunk_height,
-                                         unsigned int new_chunk_width, unsigned int new_chunk_height,
-                                         unsigned int x, unsigned int y, cv::Mat& output_image)
+void MultithreadedResizer::resize_images_pipeline(const std::string& input_images_dir, unsigned int output_width,
+                                                  unsigned int output_height, const std::string& output_images_dir)
 {
-    // Get chunk from input image.
-    cv::Rect roi(chunk_width * x, chunk_height * y, chunk_width, chunk_height);  // Region of interest.
+    boost::system::error_code error;
+    boost::filesystem::create_directories(output_images_dir, error);
 
-    cv::Mat chunk = input_image(roi);
+    if (!boost::filesystem::is_directory(output_images_dir))
+    {
+        std::cout << "Failed to create directory: " << output_images_dir << std::endl;
+        std::terminate();
+    }
+
+    // Decoding and encoding take most of the time, resizing to a small size is cheap.
+    unsigned int cores_number = threads_number_;
+    unsigned int scanners_number = std::min(cores_number, MAX_SCANNERS);
+    unsigned int decoders_number = std::max(cores_number / 2, 1u);
+    unsigned int resizers_number = std::max(cores_number / 4, 1u);
+    unsigned int encoders_number = std::max(cores_number / 2, 1u);
+
+    BoundedQueue<ImageJob> files(FILES_QUEUE_DEPTH);
+    BoundedQueue<ImageJob> decoded_images(resizers_number * IMAGES_PER_CONSUMER);
+    BoundedQueue<ImageJob> resized_images(encoders_number * IMAGES_PER_CONSUMER);
+
+    ScanState scan_state;
+    scan_state.directories.push_back(std::make_pair(boost::filesystem::path(input_images_dir),
+                                                    boost::filesystem::path(output_images_dir)));
+    scan_state.pending_directories = 1;
+    scan_state.output_root = output_images_dir;
 
-    // Resize chunk.
-    cv::resize(chunk, chunk, cv::Size(new_chunk_width, new_chunk_height));
+    const std::string extension = JPG_EXTENSION;
+    cv::Size output_size(output_width, output_height);
+
+    std::vector<std::thread> threads;
+
+    start_stage(scanners_number, [&scan_state, &extension, &files]
+    {
+        scan_directories(scan_state, extension, files);
+    }, &files, threads);
+
+    start_stage(decoders_number, [&files, &decoded_images, output_width, output_height]
+    {
+        ImageJob job;
 
-    // Merge chunk to output image.
-    chunk.copyTo(output_image(cv::Rect(new_chunk_width * x, new_chunk_height * y, new_chunk_width, new_chunk_height)));
+        while (files.pop(job))
+        {
+            get_resizer_stats().add_queue_depth(StatsQueue::pipeline_files, -1);
+
+            try
+            {
+                // Shrink-on-load, the exact size is made by the resize stage.
+                job.image = read_image_for_resize(job.input_path, ResizeSpec(output_width, output_height));
+            }
+            catch (const std::exception& error)
+            {
+                report_error("Failed to read image", job.input_path, error);
+                continue;
+            }
+
+            if (job.image.empty())
+            {
+                std::cerr << "Failed to read image: " << job.input_path << std::endl;
+                continue;
+            }
+
+            if (decoded_images.push(std::move(job)))
+            {
+                get_resizer_stats().add_queue_depth(StatsQueue::pipeline_decoded, 1);
+            }
+        }
+    }, &decoded_images, threads);
+
+    start_stage(resizers_number, [&decoded_images, &resized_images, output_size]
+    {
+        ImageJob job;
+
+        while (decoded_images.pop(job))
+        {
+            get_resizer_stats().add_queue_depth(StatsQueue::pipeline_decoded, -1);
+
+            try
+            {
+                StageTimer timer(Stage::resize);
+
+                cv::Mat resized_image = get_buffer_pool().make_image(output_size.height, output_size.width,
+                                                                     job.image.type());
+                cv::resize(job.image, resized_image, output_size);
+
+                job.image = resized_image;
+            }
+            catch (const std::exception& error)
+            {
+                report_error("Failed to resize image", job.input_path, error);
+                continue;
+            }
+
+            if (resized_images.push(std::move(job)))
+            {
+                get_resizer_stats().add_queue_depth(StatsQueue::pipeline_resized, 1);
+            }
+        }
+    }, &resized_images, threads);
+
+    start_stage(encoders_number, [&resized_images]
+    {
+        ImageJob job;
+
+        while (resized_images.pop(job))
+        {
+            get_resizer_stats().add_queue_depth(StatsQueue::pipeline_resized, -1);
+
+            try
+            {
+                if (!write_image(job.output_path, job.image))
+                {
+                    std::cerr << "Failed to save to: " << job.output_path << std::endl;
+                }
+            }
+            catch (const std::exception& error)
+            {
+                report_error("Failed to save to", job.output_path, error);
+            }
+        }
+    }, nullptr, threads);
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void MultithreadedResizer::process_chunk(const cv::Mat& input_image, unsigned int columns, unsigned int rows,
+                                         unsigned int x, unsigned int y, cv::Mat& output_image)
+{
+    // Tile edges at x * size / columns, so the last tiles take the remainder and the tiles cover both images.
+    cv::Rect input_roi(input_image.cols * x / columns, input_image.rows * y / rows,
+                       input_image.cols * (x + 1) / columns - input_image.cols * x / columns,
+                       input_image.rows * (y + 1) / rows - input_image.rows * y / rows);
+
+    cv::Rect output_roi(output_image.cols * x / columns, output_image.rows * y / rows,
+                        output_image.cols * (x + 1) / columns - output_image.cols * x / columns,
+                        output_image.rows * (y + 1) / rows - output_image.rows * y / rows);
+
+    // Resize chunk straight into its place in the output image: the region already has the target
+    // size and type, so cv::resize allocates nothing and there is no copy.
+    cv::Mat output_chunk = output_image(output_roi);
+    cv::resize(input_image(input_roi), output_chunk, output_roi.size());
 }
 
 void MultithreadedResizer::split_image(const unsigned int columns, const unsigned int rows)
@@ -308,7 +673,16 @@ void MultithreadedResizer::merge_chunk(cv::Mat& chunk, cv::Mat& output_image, un
 
 void MultithreadedResizer::read_image(const std::string& image_path)
 {
-    input_image_ = cv::imread(image_path.c_str(), CV_LOAD_IMAGE_COLOR);
+    // Decoded from the mapped file into a pooled buffer, the previous image goes back to the pool.
+    MappedFile file;
+    bool is_open;
+
+    {
+        StageTimer timer(Stage::read);
+        is_open = file.open(image_path);
+    }
+
+    input_image_ = is_open ? decode_image(file.get_bytes(), CV_LOAD_IMAGE_COLOR) : cv::Mat();
 
     if (!input_image_.empty())
     {
@@ -327,7 +701,8 @@ void MultithreadedResizer::read_image(const std::string& image_path)
 
 void MultithreadedResizer::save_image(const cv::Mat& image, const std::string& path)
 {
-    if (cv::imwrite(path, image))
+    // Encode and write timed apart.
+    if (write_image(path, image))
     {
         //std::cout << "Saved to: " << path << std::endl;
     }
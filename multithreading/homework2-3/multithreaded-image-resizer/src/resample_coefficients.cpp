@@ -0,0 +1,203 @@
+#include <map>
+#include <list>
+#include <tuple>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/resample_coefficients.h"
+
+namespace
+{
+    // Distinct geometries kept; a table of a 50MP axis is about 100KB.
+    const std::size_t COEFFICIENT_CACHE_CAPACITY = 256;
+
+    void make_area_coefficients(unsigned int source_size, unsigned int output_size, AxisCoefficients& axis)
+    {
+        // In units of 1 / output_size source pixels, output pixel i covers [i * source_size, (i + 1) * source_size)
+        // and source pixel s covers [s * output_size, (s + 1) * output_size): the overlaps are whole numbers.
+        for (unsigned int i = 0; i < output_size; ++i)
+        {
+            std::uint64_t begin = std::uint64_t(i) * source_size;
+            std::uint64_t end = begin + source_size;
+
+            unsigned int s = static_cast<unsigned int>(begin / output_size);
+            std::uint64_t covered = 0;
+            std::uint32_t assigned = 0;
+
+            axis.first[i] = s;
+
+            for (; std::uint64_t(s) * output_size < end; ++s)
+            {
+                covered += std::min<std::uint64_t>(end, std::uint64_t(s + 1) * output_size)
+                           - std::max<std::uint64_t>(begin, std::uint64_t(s) * output_size);
+
+                // Rounded running total, so rounding errors do not add up and the weights sum to one.
+                std::uint32_t total = static_cast<std::uint32_t>((covered * RESAMPLE_WEIGHT_ONE + source_size / 2)
+                                                                 / source_size);
+
+                axis.weights.push_back(total - assigned);
+                assigned = total;
+            }
+
+            axis.offsets[i + 1] = static_cast<unsigned int>(axis.weights.size());
+        }
+    }
+
+    void make_linear_coefficients(unsigned int source_size, unsigned int output_size, AxisCoefficients& axis)
+    {
+        double scale = static_cast<double>(source_size) / output_size;
+
+        for (unsigned int i = 0; i < output_size; ++i)
+        {
+            // Pixel centers line up, as in cv::resize.
+            double position = (i + 0.5) * scale - 0.5;
+            double left = std::floor(position);
+            unsigned int s = 0;
+            std::uint32_t right_weight = 0;
+
+            if (position > 0 && left + 1 < source_size)
+            {
+                s = static_cast<unsigned int>(left);
+                right_weight = static_cast<std::uint32_t>(std::lround((position - left) * RESAMPLE_WEIGHT_ONE));
+            }
+            else if (position > 0)
+            {
+                s = source_size - 1;
+            }
+
+            // Zero weights are dropped, the kernels then read one row or pixel instead of two.
+            if (right_weight == RESAMPLE_WEIGHT_ONE)
+            {
+                ++s;
+                right_weight = 0;
+            }
+
+            axis.first[i] = s;
+            axis.weights.push_back(RESAMPLE_WEIGHT_ONE - right_weight);
+
+            if (right_weight > 0)
+            {
+                axis.weights.push_back(right_weight);
+            }
+
+            axis.offsets[i + 1] = static_cast<unsigned int>(axis.weights.size());
+        }
+    }
+}
+
+AxisCoefficients make_axis_coefficients(unsigned int source_size, unsigned int output_size, ResampleFilter filter)
+{
+    AxisCoefficients axis;
+    axis.first.resize(output_size);
+    axis.offsets.resize(output_size + 1, 0);
+
+    if (filter == ResampleFilter::area)
+    {
+        make_area_coefficients(source_size, output_size, axis);
+    }
+    else
+    {
+        make_linear_coefficients(source_size, output_size, axis);
+    }
+
+    return axis;
+}
+
+CoefficientCache::CoefficientCache(std::size_t capacity) :
+    capacity_(capacity > 0 ? capacity : 1),
+    hits_(0),
+    misses_(0)
+{
+}
+
+std::shared_ptr<const AxisCoefficients> CoefficientCache::get(unsigned int source_size, unsigned int output_size,
+                                                              ResampleFilter filter)
+{
+    Key key(source_size, output_size, filter);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto found = entries_.find(key);
+
+        if (found != entries_.end())
+        {
+            ++hits_;
+            uses_.splice(uses_.begin(), uses_, found->second.use);
+
+            return found->second.coefficients;
+        }
+
+        ++misses_;
+    }
+
+    // Threads missing the same key at once each build it, the first insert wins.
+    std::shared_ptr<const AxisCoefficients> coefficients =
+        std::make_shared<const AxisCoefficients>(make_axis_coefficients(source_size, output_size, filter));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto inserted = entries_.insert(std::make_pair(key, Entry()));
+
+    if (!inserted.second)
+    {
+        return inserted.first->second.coefficients;
+    }
+
+    uses_.push_front(key);
+    inserted.first->second.coefficients = coefficients;
+    inserted.first->second.use = uses_.begin();
+
+    if (entries_.size() > capacity_)
+    {
+        entries_.erase(uses_.back());
+        uses_.pop_back();
+    }
+
+    return coefficients;
+}
+
+void CoefficientCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    entries_.clear();
+    uses_.clear();
+    hits_ = 0;
+    misses_ = 0;
+}
+
+std::size_t CoefficientCache::get_hits() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return hits_;
+}
+
+std::size_t CoefficientCache::get_misses() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return misses_;
+}
+
+double CoefficientCache::get_hit_rate() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::size_t lookups = hits_ + misses_;
+
+    return lookups > 0 ? static_cast<double>(hits_) / lookups : 0.0;
+}
+
+CoefficientCache& get_coefficient_cache()
+{
+    static CoefficientCache cache(COEFFICIENT_CACHE_CAPACITY);
+
+    return cache;
+}
@@ -0,0 +1,649 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <cstddef>
+
+#include <boost/filesystem.hpp>
+
+#include <opencv2/opencv.hpp>
+
+#include "include/image_resize.h"
+#include "include/streaming_resize.h"
+#include "include/multithreaded_resizer.h"
+
+// Every resize mode on synthetic JPEGs from VGA to 50MP, over thread counts and target sizes.
+// Medians and speedups go out as CSV; with a baseline CSV it fails on regressions, as a performance gate.
+
+namespace
+{
+    struct ImageSize
+    {
+        std::string name;
+        unsigned int width;
+        unsigned int height;
+    };
+
+    const ImageSize IMAGE_SIZES[] =
+    {
+        { "vga", 640, 480 },
+        { "hd", 1280, 720 },
+        { "fhd", 1920, 1080 },
+        { "4k", 3840, 2160 },
+        { "12mp", 4000, 3000 },
+        { "24mp", 6000, 4000 },
+        { "50mp", 8192, 6144 }
+    };
+
+    struct Mode
+    {
+        std::string name;
+        bool is_parallel;  // Swept over the thread counts, the others run on one thread.
+        bool is_tiled;     // Runs MultithreadedResizer::get_tiles_number() threads, not the number asked for.
+    };
+
+    const Mode MODES[] =
+    {
+        { "single_thread", false, false },
+        { "std_thread", true, true },
+        { "std_async", true, true },
+        { "bands", true, false },
+        { "pipeline", true, false },
+        { "stateless", true, false },
+        { "stateless_area", true, false },
+        { "streaming", false, false }
+    };
+
+    struct Options
+    {
+        std::vector<ImageSize> images;
+        std::vector<cv::Size> targets;
+        std::vector<unsigned int> threads_numbers;
+        std::vector<Mode> modes;
+
+        unsigned int iterations;
+        unsigned int pipeline_images;  // Copies of the image resized by one pipeline run.
+
+        std::string output_path;    // CSV, standard output if empty.
+        std::string baseline_path;  // CSV of an earlier run to compare with.
+        double max_regression;      // Percent.
+    };
+
+    struct Result
+    {
+        std::string mode;
+        ImageSize image;
+        cv::Size target;
+        unsigned int threads_number;
+
+        // Microseconds per image.
+        long long median_duration;
+        long long min_duration;
+        long long max_duration;
+    };
+
+    // Empty parts kept, the trailing one included: CSV rows may end with an empty field.
+    std::vector<std::string> split(const std::string& text, char separator)
+    {
+        std::vector<std::string> parts;
+        std::size_t first = 0;
+
+        for (;;)
+        {
+            std::size_t last = text.find(separator, first);
+            parts.push_back(text.substr(first, last - first));
+
+            if (last == std::string::npos)
+            {
+                return parts;
+            }
+
+            first = last + 1;
+        }
+    }
+
+    bool parse_number(const std::string& text, unsigned long long& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            value = std::stoull(text, &parsed);
+
+            return parsed == text.size() && text[0] != '-' && value > 0;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    bool parse_duration(const std::string& text, long long& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            value = std::stoll(text, &parsed);
+
+            return parsed == text.size() && value >= 0;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    std::vector<unsigned int> get_default_threads_numbers()
+    {
+        unsigned int cores_number = std::max(MultithreadedResizer::get_cores_number(), 1u);
+        std::vector<unsigned int> threads_numbers;
+
+        for (unsigned int threads_number = 1; threads_number < cores_number; threads_number *= 2)
+        {
+            threads_numbers.push_back(threads_number);
+        }
+
+        threads_numbers.push_back(cores_number);
+
+        return threads_numbers;
+    }
+
+    bool parse_options(int argc, char* argv[], Options& options)
+    {
+        options.images.assign(std::begin(IMAGE_SIZES), std::end(IMAGE_SIZES));
+        options.targets = { cv::Size(160, 90), cv::Size(640, 360), cv::Size(1280, 720) };
+        options.threads_numbers = get_default_threads_numbers();
+        options.modes.assign(std::begin(MODES), std::end(MODES));
+        options.iterations = 5;
+        options.pipeline_images = 4;
+        options.max_regression = 10.0;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string option = argv[i];
+
+            if (i + 1 == argc)
+            {
+                return false;
+            }
+
+            std::string value = argv[++i];
+            unsigned long long number = 0;
+
+            if (option == "--sizes")
+            {
+                options.images.clear();
+
+                for (const std::string& name : split(value, ','))
+                {
+                    auto found = std::find_if(std::begin(IMAGE_SIZES), std::end(IMAGE_SIZES),
+                                              [&name](const ImageSize& size) { return size.name == name; });
+
+                    if (found == std::end(IMAGE_SIZES))
+                    {
+                        std::cerr << "Unknown image size: " << name << std::endl;
+                        return false;
+                    }
+
+                    options.images.push_back(*found);
+                }
+            }
+            else if (option == "--targets")
+            {
+                options.targets.clear();
+
+                for (const std::string& target : split(value, ','))
+                {
+                    std::vector<std::string> sides = split(target, 'x');
+                    unsigned long long width = 0;
+                    unsigned long long height = 0;
+
+                    if (sides.size() != 2 || !parse_number(sides[0], width) || !parse_number(sides[1], height))
+                    {
+                        std::cerr << "Bad target size: " << target << std::endl;
+                        return false;
+                    }
+
+                    options.targets.push_back(cv::Size(static_cast<int>(width), static_cast<int>(height)));
+                }
+            }
+            else if (option == "--threads")
+            {
+                options.threads_numbers.clear();
+
+                for (const std::string& threads : split(value, ','))
+                {
+                    if (!parse_number(threads, number))
+                    {
+                        std::cerr << "Bad threads number: " << threads << std::endl;
+                        return false;
+                    }
+
+                    options.threads_numbers.push_back(static_cast<unsigned int>(number));
+                }
+
+                std::sort(options.threads_numbers.begin(), options.threads_numbers.end());
+            }
+            else if (option == "--modes")
+            {
+                options.modes.clear();
+
+                for (const std::string& name : split(value, ','))
+                {
+                    auto found = std::find_if(std::begin(MODES), std::end(MODES),
+                                              [&name](const Mode& mode) { return mode.name == name; });
+
+                    if (found == std::end(MODES))
+                    {
+                        std::cerr << "Unknown mode: " << name << std::endl;
+                        return false;
+                    }
+
+                    options.modes.push_back(*found);
+                }
+            }
+            else if (option == "--iterations" && parse_number(value, number))
+            {
+                options.iterations = static_cast<unsigned int>(number);
+            }
+            else if (option == "--pipeline-images" && parse_number(value, number))
+            {
+                options.pipeline_images = static_cast<unsigned int>(number);
+            }
+            else if (option == "--output")
+            {
+                options.output_path = value;
+            }
+            else if (option == "--baseline")
+            {
+                options.baseline_path = value;
+            }
+            else if (option == "--max-regression" && parse_number(value, number))
+            {
+                options.max_regression = static_cast<double>(number);
+            }
+            else
+            {
+                std::cerr << "Bad option: " << option << " " << value << std::endl;
+                return false;
+            }
+        }
+
+        return !options.images.empty() && !options.targets.empty() && !options.threads_numbers.empty()
+               && !options.modes.empty();
+    }
+
+    void print_usage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " [--sizes vga,hd,fhd,4k,12mp,24mp,50mp] [--targets 160x90,...]"
+                  << " [--threads 1,2,4,...] [--modes single_thread,std_thread,std_async,bands,pipeline,stateless,"
+                  << "stateless_area,streaming] [--iterations N] [--pipeline-images N] [--output results.csv]"
+                  << " [--baseline baseline.csv] [--max-regression percent]" << std::endl;
+    }
+
+    // One untimed warmup run, then the measured ones. Durations in microseconds.
+    std::vector<long long> measure(unsigned int iterations, const std::function<void()>& run)
+    {
+        std::vector<long long> durations;
+
+        for (unsigned int iteration = 0; iteration <= iterations; ++iteration)
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            run();
+            std::chrono::high_resolution_clock::time_point finish = std::chrono::high_resolution_clock::now();
+
+            if (iteration > 0)
+            {
+                durations.push_back(std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count());
+            }
+        }
+
+        return durations;
+    }
+
+    // Runs the mode on the image, false if it failed.
+    bool run_mode(const Mode& mode, const std::string& image_path, const std::string& pipeline_dir,
+                  const std::string& work_dir, cv::Size target, unsigned int threads_number,
+                  MultithreadedResizer& resizer)
+    {
+        std::string output_path = work_dir + "/output.jpg";
+
+        resizer.set_threads_number(threads_number);
+        set_resize_threads_number(threads_number);
+
+        if (mode.name == "single_thread")
+        {
+            resizer.resize_image_single_thread(image_path, target.width, target.height, output_path);
+        }
+        else if (mode.name == "std_thread")
+        {
+            resizer.resize_image_std_thread(image_path, target.width, target.height, output_path);
+        }
+        else if (mode.name == "std_async")
+        {
+            resizer.resize_image_std_async(image_path, target.width, target.height, output_path);
+        }
+        else if (mode.name == "bands")
+        {
+            resizer.resize_image_bands(image_path, target.width, target.height, output_path);
+        }
+        else if (mode.name == "pipeline")
+        {
+            resizer.resize_images_pipeline(pipeline_dir, target.width, target.height, work_dir + "/pipeline-output");
+        }
+        else if (mode.name == "stateless")
+        {
+            return resize_image_file(image_path, output_path, ResizeSpec(target.width, target.height));
+        }
+        else if (mode.name == "stateless_area")
+        {
+            return resize_image_file(image_path, output_path, ResizeSpec(target.width, target.height, cv::INTER_AREA));
+        }
+        else if (mode.name == "streaming")
+        {
+            return resizer.resize_image_streaming(image_path, target.width, target.height, output_path);
+        }
+
+        return true;
+    }
+
+    // Copies of the image for the pipeline mode, which resizes whole directories.
+    bool make_pipeline_dir(const std::string& image_path, const std::string& pipeline_dir, unsigned int images_number)
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove_all(pipeline_dir, error);
+        boost::filesystem::create_directories(pipeline_dir, error);
+
+        for (unsigned int i = 0; i < images_number && !error; ++i)
+        {
+            boost::filesystem::copy_file(image_path, pipeline_dir + "/image" + std::to_string(i) + ".jpg", error);
+        }
+
+        return !error;
+    }
+
+    std::string get_result_key(const std::string& mode, const std::string& image, int target_width, int target_height,
+                               unsigned int threads_number)
+    {
+        return mode + "," + image + "," + std::to_string(target_width) + "," + std::to_string(target_height) + ","
+               + std::to_string(threads_number);
+    }
+
+    void print_results(const std::vector<Result>& results, std::ostream& out)
+    {
+        std::map<std::string, long long> medians;
+
+        for (const Result& result : results)
+        {
+            medians[get_result_key(result.mode, result.image.name, result.target.width, result.target.height,
+                                   result.threads_number)] = result.median_duration;
+        }
+
+        out << "mode,image,width,height,megapixels,target_width,target_height,threads,median_us,min_us,max_us,"
+            << "speedup,speedup_vs_single_thread" << std::endl;
+
+        for (const Result& result : results)
+        {
+            out << result.mode << ',' << result.image.name << ',' << result.image.width << ',' << result.image.height
+                << ',' << result.image.width * static_cast<double>(result.image.height) / 1e6 << ','
+                << result.target.width << ',' << result.target.height << ',' << result.threads_number << ','
+                << result.median_duration << ',' << result.min_duration << ',' << result.max_duration << ',';
+
+            // Against the same mode on the fewest threads measured, and against the original single-threaded mode.
+            auto first = std::find_if(results.begin(), results.end(), [&result](const Result& other)
+            {
+                return other.mode == result.mode && other.image.name == result.image.name
+                       && other.target == result.target;
+            });
+
+            out << static_cast<double>(first->median_duration) / std::max(1ll, result.median_duration) << ',';
+
+            auto single_thread = medians.find(get_result_key("single_thread", result.image.name, result.target.width,
+                                                             result.target.height, 1));
+
+            if (single_thread != medians.end())
+            {
+                out << static_cast<double>(single_thread->second) / std::max(1ll, result.median_duration);
+            }
+
+            out << std::endl;
+        }
+    }
+
+    // False if some median is more than max_regression percent slower than in the baseline.
+    bool check_baseline(const Options& options, const std::vector<Result>& results)
+    {
+        std::ifstream baseline(options.baseline_path);
+        std::string line;
+
+        if (!std::getline(baseline, line))
+        {
+            std::cerr << "Failed to read baseline: " << options.baseline_path << std::endl;
+            return false;
+        }
+
+        std::vector<std::string> header = split(line, ',');
+        std::map<std::string, std::size_t> columns;
+
+        for (std::size_t i = 0; i < header.size(); ++i)
+        {
+            columns[header[i]] = i;
+        }
+
+        const char* required_columns[] = { "mode", "image", "target_width", "target_height", "threads", "median_us" };
+
+        for (const char* column : required_columns)
+        {
+            if (columns.count(column) == 0)
+            {
+                std::cerr << "Baseline has no column: " << column << std::endl;
+                return false;
+            }
+        }
+
+        std::map<std::string, long long> baseline_medians;
+
+        for (std::size_t line_number = 2; std::getline(baseline, line); ++line_number)
+        {
+            if (line.empty())
+            {
+                continue;
+            }
+
+            std::vector<std::string> fields = split(line, ',');
+            long long median_duration = 0;
+
+            if (fields.size() < header.size() || !parse_duration(fields[columns["median_us"]], median_duration))
+            {
+                std::cerr << "Bad line " << line_number << " of baseline: " << options.baseline_path << std::endl;
+                return false;
+            }
+
+            baseline_medians[fields[columns["mode"]] + "," + fields[columns["image"]] + ","
+                             + fields[columns["target_width"]] + "," + fields[columns["target_height"]] + ","
+                             + fields[columns["threads"]]] = median_duration;
+        }
+
+        bool passed = true;
+        std::size_t compared_number = 0;
+
+        for (const Result& result : results)
+        {
+            auto found = baseline_medians.find(get_result_key(result.mode, result.image.name, result.target.width,
+                                                              result.target.height, result.threads_number));
+
+            if (found == baseline_medians.end())
+            {
+                continue;
+            }
+
+            ++compared_number;
+
+            double change = (static_cast<double>(result.median_duration) / std::max(1ll, found->second) - 1.0) * 100.0;
+
+            if (change > options.max_regression)
+            {
+                std::cerr << "Regression: " << found->first << ": " << found->second << " -> " << result.median_duration
+                          << " microseconds (+" << change << "%)." << std::endl;
+                passed = false;
+            }
+        }
+
+        std::cerr << "Compared " << compared_number << " results with the baseline, "
+                  << (passed ? "no regressions." : "regressions found.") << std::endl;
+
+        return passed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    boost::system::error_code error;
+    boost::filesystem::path work_dir = boost::filesystem::temp_directory_path(error)
+                                       / boost::filesystem::unique_path("resizer-benchmark-%%%%%%%%");
+
+    if (error || !boost::filesystem::create_directories(work_dir, error))
+    {
+        std::cerr << "Failed to create work directory: " << work_dir.string() << std::endl;
+        return 1;
+    }
+
+    MultithreadedResizer resizer;
+    std::vector<Result> results;
+    bool is_failed = false;
+
+    for (const ImageSize& image : options.images)
+    {
+        std::string image_path = (work_dir / (image.name + ".jpg")).string();
+        std::string pipeline_dir = (work_dir / "pipeline-input").string();
+
+        if (!write_synthetic_jpeg(image_path, image.width, image.height)
+            || !make_pipeline_dir(image_path, pipeline_dir, options.pipeline_images))
+        {
+            std::cerr << "Failed to write synthetic image: " << image_path << std::endl;
+            is_failed = true;
+            break;
+        }
+
+        for (cv::Size target : options.targets)
+        {
+            // Downscaling only, which every mode supports.
+            if (static_cast<unsigned int>(target.width) > image.width
+                || static_cast<unsigned int>(target.height) > image.height)
+            {
+                continue;
+            }
+
+            for (const Mode& mode : options.modes)
+            {
+                std::vector<unsigned int> threads_numbers = options.threads_numbers;
+
+                if (!mode.is_parallel)
+                {
+                    threads_numbers.assign(1, 1);
+                }
+
+                std::vector<unsigned int> measured_threads_numbers;
+
+                for (unsigned int threads_number : threads_numbers)
+                {
+                    // Tiled modes are reported with the threads they run, several numbers asked may give the same.
+                    unsigned int used_threads_number = threads_number;
+
+                    if (mode.is_tiled)
+                    {
+                        resizer.set_threads_number(threads_number);
+                        used_threads_number = resizer.get_tiles_number();
+                    }
+
+                    if (std::find(measured_threads_numbers.begin(), measured_threads_numbers.end(), used_threads_number)
+                        != measured_threads_numbers.end())
+                    {
+                        continue;
+                    }
+
+                    measured_threads_numbers.push_back(used_threads_number);
+
+                    bool is_done = true;
+
+                    std::vector<long long> durations = measure(options.iterations, [&]
+                    {
+                        is_done = run_mode(mode, image_path, pipeline_dir, work_dir.string(), target, threads_number,
+                                           resizer) && is_done;
+                    });
+
+                    if (!is_done)
+                    {
+                        std::cerr << "Failed: " << mode.name << " on " << image.name << "." << std::endl;
+                        is_failed = true;
+                        continue;
+                    }
+
+                    // Pipeline runs resize a directory of copies, durations are per image as for the other modes.
+                    unsigned int images_number = mode.name == "pipeline" ? options.pipeline_images : 1;
+
+                    for (auto& duration : durations)
+                    {
+                        duration /= images_number;
+                    }
+
+                    Result result;
+                    result.mode = mode.name;
+                    result.image = image;
+                    result.target = target;
+                    result.threads_number = used_threads_number;
+                    result.min_duration = *std::min_element(durations.begin(), durations.end());
+                    result.max_duration = *std::max_element(durations.begin(), durations.end());
+
+                    std::nth_element(durations.begin(), durations.begin() + durations.size() / 2, durations.end());
+                    result.median_duration = durations[durations.size() / 2];
+
+                    std::cerr << image.name << " -> " << target.width << "x" << target.height << ", " << mode.name
+                              << ", " << used_threads_number << " threads: " << result.median_duration
+                              << " microseconds." << std::endl;
+
+                    results.push_back(result);
+                }
+            }
+        }
+
+        boost::filesystem::remove(image_path, error);
+    }
+
+    set_resize_threads_number(0);
+    boost::filesystem::remove_all(work_dir, error);
+
+    if (options.output_path.empty())
+    {
+        print_results(results, std::cout);
+    }
+    else
+    {
+        std::ofstream output(options.output_path);
+        print_results(results, output);
+
+        if (!output)
+        {
+            std::cerr << "Failed to write results: " << options.output_path << std::endl;
+            is_failed = true;
+        }
+    }
+
+    if (!options.baseline_path.empty() && !check_baseline(options, results))
+    {
+        is_failed = true;
+    }
+
+    return is_failed ? 1 : 0;
+}
@@ -0,0 +1,331 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/resizer_stats.h"
+
+namespace
+{
+    const char* const STAGE_NAMES[STAGES_NUMBER] = { "read", "decode", "resize", "encode", "write" };
+    const char* const QUEUE_NAMES[STATS_QUEUES_NUMBER] = { "pool_tasks", "pipeline_files", "pipeline_decoded",
+                                                           "pipeline_resized" };
+
+    const double PERCENTILES[] = { 50.0, 90.0, 99.0 };
+
+    unsigned int get_latency_bucket(std::uint64_t duration_ns)
+    {
+        std::uint64_t duration_us = duration_ns / 1000;
+
+        if (duration_us == 0)
+        {
+            return 0;
+        }
+
+        unsigned int bucket = 64 - __builtin_clzll(duration_us);
+
+        return std::min(bucket, LATENCY_BUCKETS_NUMBER - 1);
+    }
+
+    template <typename T>
+    void update_max(std::atomic<T>& max, T value)
+    {
+        T current = max.load(std::memory_order_relaxed);
+
+        while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::uint64_t get_nanoseconds(std::chrono::steady_clock::duration duration)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+}
+
+const char* get_stage_name(Stage stage)
+{
+    return STAGE_NAMES[static_cast<unsigned int>(stage)];
+}
+
+const char* get_queue_name(StatsQueue queue)
+{
+    return QUEUE_NAMES[static_cast<unsigned int>(queue)];
+}
+
+double LatencySnapshot::get_mean_us() const
+{
+    return count > 0 ? total_ns / 1000.0 / count : 0.0;
+}
+
+double LatencySnapshot::get_percentile_us(double percentile) const
+{
+    if (count == 0)
+    {
+        return 0.0;
+    }
+
+    // Rank of the percentile, counted from 1.
+    std::uint64_t rank = std::max<std::uint64_t>(static_cast<std::uint64_t>(percentile / 100.0 * count + 0.5), 1);
+    std::uint64_t counted = 0;
+
+    for (unsigned int bucket = 0; bucket < LATENCY_BUCKETS_NUMBER; ++bucket)
+    {
+        counted += buckets[bucket];
+
+        if (counted >= rank)
+        {
+            return std::min(static_cast<double>(std::uint64_t(1) << bucket), max_ns / 1000.0);
+        }
+    }
+
+    return max_ns / 1000.0;
+}
+
+double ResizerStatsSnapshot::get_worker_utilization() const
+{
+    return worker_capacity_ns > 0 ? std::min(static_cast<double>(worker_busy_ns) / worker_capacity_ns, 1.0) : 0.0;
+}
+
+ResizerStats::ResizerStats() :
+    start_(std::chrono::steady_clock::now()),
+    workers_number_(0),
+    worker_capacity_ns_(0),
+    workers_changed_(start_),
+    worker_busy_ns_(0),
+    bytes_in_(0),
+    bytes_out_(0)
+{
+    for (auto& histogram : stages_)
+    {
+        histogram.count = 0;
+        histogram.total_ns = 0;
+        histogram.max_ns = 0;
+
+        for (auto& bucket : histogram.buckets)
+        {
+            bucket = 0;
+        }
+    }
+
+    for (auto& queue : queues_)
+    {
+        queue.depth = 0;
+        queue.max_depth = 0;
+        queue.pushes = 0;
+    }
+}
+
+void ResizerStats::add_latency(Stage stage, std::uint64_t duration_ns)
+{
+    Histogram& histogram = stages_[static_cast<unsigned int>(stage)];
+
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.total_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+    histogram.buckets[get_latency_bucket(duration_ns)].fetch_add(1, std::memory_order_relaxed);
+    update_max(histogram.max_ns, duration_ns);
+}
+
+void ResizerStats::add_queue_depth(StatsQueue queue, int change)
+{
+    QueueCounters& counters = queues_[static_cast<unsigned int>(queue)];
+
+    std::int64_t depth = counters.depth.fetch_add(change, std::memory_order_relaxed) + change;
+
+    if (change > 0)
+    {
+        counters.pushes.fetch_add(change, std::memory_order_relaxed);
+        update_max(counters.max_depth, depth);
+    }
+}
+
+void ResizerStats::add_workers(int change)
+{
+    std::lock_guard<std::mutex> lock(workers_mutex_);
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    worker_capacity_ns_ += workers_number_ * get_nanoseconds(now - workers_changed_);
+    workers_changed_ = now;
+    workers_number_ += change;
+}
+
+void ResizerStats::add_busy_time(std::uint64_t duration_ns)
+{
+    worker_busy_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+}
+
+ResizerStatsSnapshot ResizerStats::get_stats() const
+{
+    ResizerStatsSnapshot stats;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    stats.uptime_seconds = get_nanoseconds(now - start_) / 1e9;
+
+    for (unsigned int i = 0; i < STAGES_NUMBER; ++i)
+    {
+        stats.stages[i].count = stages_[i].count.load(std::memory_order_relaxed);
+        stats.stages[i].total_ns = stages_[i].total_ns.load(std::memory_order_relaxed);
+        stats.stages[i].max_ns = stages_[i].max_ns.load(std::memory_order_relaxed);
+
+        for (unsigned int bucket = 0; bucket < LATENCY_BUCKETS_NUMBER; ++bucket)
+        {
+            stats.stages[i].buckets[bucket] = stages_[i].buckets[bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    for (unsigned int i = 0; i < STATS_QUEUES_NUMBER; ++i)
+    {
+        stats.queues[i].depth = queues_[i].depth.load(std::memory_order_relaxed);
+        stats.queues[i].max_depth = queues_[i].max_depth.load(std::memory_order_relaxed);
+        stats.queues[i].pushes = queues_[i].pushes.load(std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workers_mutex_);
+
+        stats.workers_number = workers_number_;
+        stats.worker_capacity_ns = worker_capacity_ns_ + workers_number_ * get_nanoseconds(now - workers_changed_);
+    }
+
+    stats.worker_busy_ns = worker_busy_ns_.load(std::memory_order_relaxed);
+    stats.bytes_in = bytes_in_.load(std::memory_order_relaxed);
+    stats.bytes_out = bytes_out_.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+ResizerStats& get_resizer_stats()
+{
+    static ResizerStats* stats = new ResizerStats();
+
+    return *stats;
+}
+
+ResizerStatsSnapshot get_stats()
+{
+    return get_resizer_stats().get_stats();
+}
+
+std::string stats_to_json(const ResizerStatsSnapshot& stats)
+{
+    std::ostringstream json;
+
+    json << "{\"uptime_s\":" << stats.uptime_seconds << ",\"stages\":{";
+
+    for (unsigned int i = 0; i < STAGES_NUMBER; ++i)
+    {
+        const LatencySnapshot& stage = stats.stages[i];
+
+        json << (i > 0 ? "," : "") << '"' << STAGE_NAMES[i] << "\":{\"count\":" << stage.count
+             << ",\"mean_us\":" << stage.get_mean_us();
+
+        for (double percentile : PERCENTILES)
+        {
+            json << ",\"p" << percentile << "_us\":" << stage.get_percentile_us(percentile);
+        }
+
+        json << ",\"max_us\":" << stage.max_ns / 1000.0 << ",\"buckets\":[";
+
+        // Trailing empty buckets left out.
+        unsigned int buckets_number = LATENCY_BUCKETS_NUMBER;
+
+        while (buckets_number > 0 && stage.buckets[buckets_number - 1] == 0)
+        {
+            --buckets_number;
+        }
+
+        for (unsigned int bucket = 0; bucket < buckets_number; ++bucket)
+        {
+            json << (bucket > 0 ? "," : "") << stage.buckets[bucket];
+        }
+
+        json << "]}";
+    }
+
+    json << "},\"queues\":{";
+
+    for (unsigned int i = 0; i < STATS_QUEUES_NUMBER; ++i)
+    {
+        json << (i > 0 ? "," : "") << '"' << QUEUE_NAMES[i] << "\":{\"depth\":" << stats.queues[i].depth
+             << ",\"max_depth\":" << stats.queues[i].max_depth << ",\"pushes\":" << stats.queues[i].pushes << '}';
+    }
+
+    json << "},\"workers\":{\"number\":" << stats.workers_number << ",\"busy_s\":" << stats.worker_busy_ns / 1e9
+         << ",\"utilization\":" << stats.get_worker_utilization() << '}'
+         << ",\"bytes_in\":" << stats.bytes_in << ",\"bytes_out\":" << stats.bytes_out << '}';
+
+    return json.str();
+}
+
+StageTimer::StageTimer(Stage stage) :
+    stage_(stage),
+    start_(std::chrono::steady_clock::now())
+{
+}
+
+StageTimer::~StageTimer()
+{
+    get_resizer_stats().add_latency(stage_, get_nanoseconds(std::chrono::steady_clock::now() - start_));
+}
+
+StatsReporter::StatsReporter(const std::string& path, unsigned int interval_ms) :
+    path_(path),
+    interval_(std::max(interval_ms, 1u)),
+    stop_(false),
+    thread_(&StatsReporter::report_loop, this)
+{
+}
+
+StatsReporter::~StatsReporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    stop_requested_.notify_all();
+    thread_.join();
+
+    write_report();
+}
+
+void StatsReporter::report_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stop_requested_.wait_for(lock, interval_, [this] { return stop_; }))
+    {
+        lock.unlock();
+        write_report();
+        lock.lock();
+    }
+}
+
+bool StatsReporter::write_report() const
+{
+    std::string temporary_path = path_ + ".tmp";
+
+    {
+        std::ofstream file(temporary_path, std::ios::trunc);
+
+        file << stats_to_json(get_stats()) << '\n';
+        file.close();
+
+        if (!file)
+        {
+            std::remove(temporary_path.c_str());
+            return false;
+        }
+    }
+
+    return std::rename(temporary_path.c_str(), path_.c_str()) == 0;
+}
@@ -0,0 +1,374 @@
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "include/mapped_file.h"
+#include "include/result_manifest.h"
+
+namespace
+{
+    const std::string MANIFEST_HEADER = "resize-manifest 1";
+
+    // Piece of a file hashed at a time.
+    const std::size_t HASH_READ_BYTES = std::size_t(1) << 20;
+
+    const std::uint64_t PRIME_1 = 11400714785074694791ull;
+    const std::uint64_t PRIME_2 = 14029467366897019727ull;
+    const std::uint64_t PRIME_3 = 1609587929392839161ull;
+    const std::uint64_t PRIME_4 = 9650029242287828579ull;
+    const std::uint64_t PRIME_5 = 2870177450012600261ull;
+
+    std::uint64_t rotate_left(std::uint64_t value, unsigned int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // Unaligned little-endian reads.
+    std::uint64_t read_64(const unsigned char* data)
+    {
+        std::uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+
+        return value;
+    }
+
+    std::uint32_t read_32(const unsigned char* data)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+
+        return value;
+    }
+
+    std::uint64_t hash_round(std::uint64_t accumulator, std::uint64_t input)
+    {
+        accumulator += input * PRIME_2;
+        accumulator = rotate_left(accumulator, 31);
+
+        return accumulator * PRIME_1;
+    }
+
+    std::uint64_t merge_round(std::uint64_t hash, std::uint64_t accumulator)
+    {
+        hash ^= hash_round(0, accumulator);
+
+        return hash * PRIME_1 + PRIME_4;
+    }
+
+    void process_stripe(std::uint64_t* lanes, const unsigned char* stripe)
+    {
+        lanes[0] = hash_round(lanes[0], read_64(stripe));
+        lanes[1] = hash_round(lanes[1], read_64(stripe + 8));
+        lanes[2] = hash_round(lanes[2], read_64(stripe + 16));
+        lanes[3] = hash_round(lanes[3], read_64(stripe + 24));
+    }
+}
+
+std::uint64_t hash_bytes(ByteSpan bytes)
+{
+    StreamingHash hash;
+    hash.update(bytes);
+
+    return hash.get_hash();
+}
+
+StreamingHash::StreamingHash() :
+    stripe_size_(0),
+    total_size_(0)
+{
+    // Four independent lanes keep the multipliers busy.
+    lanes_[0] = PRIME_1 + PRIME_2;
+    lanes_[1] = PRIME_2;
+    lanes_[2] = 0;
+    lanes_[3] = 0 - PRIME_1;
+}
+
+void StreamingHash::update(ByteSpan bytes)
+{
+    const unsigned char* data = bytes.data;
+    const unsigned char* end = bytes.data + bytes.size;
+
+    if (bytes.size == 0)
+    {
+        return;
+    }
+
+    total_size_ += bytes.size;
+
+    if (stripe_size_ > 0)
+    {
+        std::size_t size = std::min(sizeof(stripe_) - stripe_size_, bytes.size);
+        std::memcpy(stripe_ + stripe_size_, data, size);
+        stripe_size_ += size;
+        data += size;
+
+        if (stripe_size_ < sizeof(stripe_))
+        {
+            return;
+        }
+
+        process_stripe(lanes_, stripe_);
+        stripe_size_ = 0;
+    }
+
+    for (; end - data >= 32; data += 32)
+    {
+        process_stripe(lanes_, data);
+    }
+
+    std::memcpy(stripe_, data, end - data);
+    stripe_size_ = end - data;
+}
+
+std::uint64_t StreamingHash::get_hash() const
+{
+    const unsigned char* data = stripe_;
+    const unsigned char* end = stripe_ + stripe_size_;
+    std::uint64_t hash;
+
+    if (total_size_ >= 32)
+    {
+        hash = rotate_left(lanes_[0], 1) + rotate_left(lanes_[1], 7) + rotate_left(lanes_[2], 12)
+               + rotate_left(lanes_[3], 18);
+        hash = merge_round(hash, lanes_[0]);
+        hash = merge_round(hash, lanes_[1]);
+        hash = merge_round(hash, lanes_[2]);
+        hash = merge_round(hash, lanes_[3]);
+    }
+    else
+    {
+        hash = PRIME_5;
+    }
+
+    hash += total_size_;
+
+    for (; data + 8 <= end; data += 8)
+    {
+        hash ^= hash_round(0, read_64(data));
+        hash = rotate_left(hash, 27) * PRIME_1 + PRIME_4;
+    }
+
+    if (data + 4 <= end)
+    {
+        hash ^= read_32(data) * PRIME_1;
+        hash = rotate_left(hash, 23) * PRIME_2 + PRIME_3;
+        data += 4;
+    }
+
+    for (; data < end; ++data)
+    {
+        hash ^= *data * PRIME_5;
+        hash = rotate_left(hash, 11) * PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+bool hash_file(const std::string& path, std::uint64_t& hash)
+{
+    // Read rather than mapped: the watcher hashes files that writers may still truncate.
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> buffer(HASH_READ_BYTES);
+    StreamingHash file_hash;
+
+    for (;;)
+    {
+        ssize_t read_size = ::read(fd, buffer.data(), buffer.size());
+
+        if (read_size > 0)
+        {
+            file_hash.update(ByteSpan(buffer.data(), read_size));
+        }
+        else if (read_size == 0)
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            int read_error = errno;
+            ::close(fd);
+            errno = read_error;
+            return false;
+        }
+    }
+
+    ::close(fd);
+    hash = file_hash.get_hash();
+
+    return true;
+}
+
+const std::string ResultManifest::FILE_NAME = ".resize_manifest";
+
+ResultManifest::ResultManifest() :
+    hits_(0),
+    misses_(0)
+{
+}
+
+void ResultManifest::load(const std::string& path)
+{
+    path_ = path;
+    entries_.clear();
+    checked_.clear();
+
+    std::ifstream file(path);
+    std::string line;
+
+    if (!std::getline(file, line) || line != MANIFEST_HEADER)
+    {
+        return;
+    }
+
+    // One entry per line: hash, input and output states, parameters, then the paths, each on the rest of its line.
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        Entry entry;
+        std::string input_path;
+
+        fields >> std::hex >> entry.content_hash >> std::dec
+               >> entry.input.size >> entry.input.time >> entry.output.size >> entry.output.time
+               >> entry.parameters;
+
+        if (!fields || !std::getline(file, input_path) || !std::getline(file, entry.output_path))
+        {
+            // Damaged tail: what was read so far is kept.
+            break;
+        }
+
+        entries_[input_path] = entry;
+    }
+}
+
+bool ResultManifest::save() const
+{
+    std::string temporary_path = path_ + ".tmp";
+
+    {
+        std::ofstream file(temporary_path, std::ios::trunc);
+
+        file << MANIFEST_HEADER << '\n';
+
+        for (const auto& entry : entries_)
+        {
+            file << std::hex << entry.second.content_hash << std::dec << ' '
+                 << entry.second.input.size << ' ' << entry.second.input.time << ' '
+                 << entry.second.output.size << ' ' << entry.second.output.time << ' '
+                 << entry.second.parameters << '\n'
+                 << entry.first << '\n'
+                 << entry.second.output_path << '\n';
+        }
+
+        file.close();
+
+        if (!file)
+        {
+            std::remove(temporary_path.c_str());
+            return false;
+        }
+    }
+
+    return std::rename(temporary_path.c_str(), path_.c_str()) == 0;
+}
+
+bool ResultManifest::is_up_to_date(const std::string& input_path, const std::string& parameters,
+                                   const std::string& output_path)
+{
+    Entry checked;
+    checked.parameters = parameters;
+    checked.output_path = output_path;
+
+    auto found = entries_.find(input_path);
+    bool is_recorded = found != entries_.end();
+
+    if (get_file_state(input_path, checked.input))
+    {
+        // Unchanged size and time: the recorded hash is trusted, so unchanged trees are not read.
+        if (is_recorded && found->second.input == checked.input)
+        {
+            checked.content_hash = found->second.content_hash;
+        }
+        else if (!hash_file(input_path, checked.content_hash))
+        {
+            checked.input = FileState();
+        }
+    }
+
+    FileState output;
+
+    bool is_hit = is_recorded && checked.input.size > 0
+                  && found->second.content_hash == checked.content_hash
+                  && found->second.parameters == parameters
+                  && found->second.output_path == output_path
+                  && get_file_state(output_path, output) && found->second.output == output;
+
+    if (is_hit)
+    {
+        // The input may have been touched without changing; the new time saves rehashing next run.
+        found->second.input = checked.input;
+        checked_.erase(input_path);
+        ++hits_;
+    }
+    else
+    {
+        checked_[input_path] = checked;
+        ++misses_;
+    }
+
+    return is_hit;
+}
+
+void ResultManifest::record(const std::string& input_path, const std::string& parameters,
+                            const std::string& output_path)
+{
+    auto checked = checked_.find(input_path);
+
+    if (checked == checked_.end() || parameters != checked->second.parameters
+        || output_path != checked->second.output_path || !get_file_state(output_path, checked->second.output))
+    {
+        return;
+    }
+
+    entries_[input_path] = checked->second;
+    checked_.erase(checked);
+}
+
+bool ResultManifest::get_file_state(const std::string& path, FileState& state)
+{
+    struct stat file_stat;
+
+    if (::stat(path.c_str(), &file_stat) != 0)
+    {
+        return false;
+    }
+
+    state.size = file_stat.st_size;
+    state.time = std::int64_t(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec;
+
+    return true;
+}
@@ -0,0 +1,185 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/filesystem.hpp>
+
+#include "include/image_resize.h"
+#include "include/area_downscale.h"
+#include "include/jpeg_stream.h"
+#include "include/streaming_resize.h"
+#include "include/resizer_stats.h"
+
+namespace
+{
+    const unsigned int SCALE_DENOMINATORS[] = { 8, 4, 2 };
+
+    // Biggest DCT-domain reduction still decoding at least the target size, as get_reduced_read_flag.
+    unsigned int get_scale_denominator(unsigned int width, unsigned int height, const ResizeSpec& spec)
+    {
+        for (unsigned int denominator : SCALE_DENOMINATORS)
+        {
+            if ((width + denominator - 1) / denominator >= spec.width
+                && (height + denominator - 1) / denominator >= spec.height)
+            {
+                return denominator;
+            }
+        }
+
+        return 1;
+    }
+
+    std::uint64_t get_elapsed_ns(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool stream_jpeg(const std::string& source_path, const std::string& output_path, const ResizeSpec& spec,
+                     int quality, StreamingStats& stats)
+    {
+        JpegStripReader reader;
+
+        if (!reader.open(source_path)
+            || !reader.start(get_scale_denominator(reader.get_image_width(), reader.get_image_height(), spec)))
+        {
+            return false;
+        }
+
+        unsigned int width = reader.get_width();
+        unsigned int height = reader.get_height();
+        unsigned int channels = reader.get_channels();
+
+        JpegRowWriter writer;
+
+        if (!writer.open(output_path, spec.width, spec.height, channels, quality))
+        {
+            return false;
+        }
+
+        bool is_written = true;
+
+        // Decoding, resizing and encoding are interleaved row by row, their times are added up
+        // and recorded once per image.
+        std::uint64_t decode_ns = 0;
+        std::uint64_t resize_ns = 0;
+        std::uint64_t encode_ns = 0;
+
+        StreamingResampler resampler(width, height, spec.width, spec.height, channels,
+                                     spec.interpolation == cv::INTER_AREA ? ResampleFilter::area : ResampleFilter::linear,
+                                     [&writer, &is_written, &encode_ns](unsigned int, const unsigned char* row)
+        {
+            std::chrono::steady_clock::time_point encode_start = std::chrono::steady_clock::now();
+            is_written = is_written && writer.write_rows(row, 0, 1);
+            encode_ns += get_elapsed_ns(encode_start);
+        });
+
+        std::size_t row_size = std::size_t(width) * channels;
+        std::vector<unsigned char> strip(row_size * STREAMING_STRIP_ROWS);
+
+        for (unsigned int y = 0; y < height && is_written; )
+        {
+            std::chrono::steady_clock::time_point decode_start = std::chrono::steady_clock::now();
+            unsigned int rows_number = reader.read_rows(strip.data(), row_size, STREAMING_STRIP_ROWS);
+            decode_ns += get_elapsed_ns(decode_start);
+
+            if (rows_number == 0)
+            {
+                return false;
+            }
+
+            std::chrono::steady_clock::time_point resize_start = std::chrono::steady_clock::now();
+
+            for (unsigned int i = 0; i < rows_number; ++i)
+            {
+                resampler.push_row(strip.data() + i * row_size);
+            }
+
+            resize_ns += get_elapsed_ns(resize_start);
+
+            y += rows_number;
+        }
+
+        stats.decoded_width = width;
+        stats.decoded_height = height;
+        stats.peak_buffer_bytes = strip.size() + resampler.get_peak_state_bytes();
+
+        std::chrono::steady_clock::time_point finish_start = std::chrono::steady_clock::now();
+        bool is_finished = is_written && resampler.is_finished() && writer.finish();
+        encode_ns += get_elapsed_ns(finish_start);
+
+        // Rows handed to the writer while resizing are encoding time.
+        ResizerStats& resizer_stats = get_resizer_stats();
+        resizer_stats.add_latency(Stage::decode, decode_ns);
+        resizer_stats.add_latency(Stage::resize, resize_ns > encode_ns ? resize_ns - encode_ns : 0);
+        resizer_stats.add_latency(Stage::encode, encode_ns);
+
+        return is_finished;
+    }
+}
+
+bool resize_jpeg_streaming(const std::string& source_path, const std::string& output_path, const ResizeSpec& spec,
+                           int quality, StreamingStats* stats)
+{
+    if (spec.width == 0 || spec.height == 0)
+    {
+        return false;
+    }
+
+    StreamingStats local_stats = StreamingStats();
+
+    if (!stream_jpeg(source_path, output_path, spec, quality, stats != nullptr ? *stats : local_stats))
+    {
+        std::remove(output_path.c_str());
+        return false;
+    }
+
+    boost::system::error_code error;
+    ResizerStats& resizer_stats = get_resizer_stats();
+    resizer_stats.add_bytes_in(boost::filesystem::file_size(source_path, error));
+    resizer_stats.add_bytes_out(boost::filesystem::file_size(output_path, error));
+
+    return true;
+}
+
+bool write_synthetic_jpeg(const std::string& path, unsigned int width, unsigned int height, int quality)
+{
+    JpegRowWriter writer;
+
+    if (!writer.open(path, width, height, 3, quality))
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> row(std::size_t(width) * 3);
+
+    // Diagonal gradients with a checkerboard, so both smooth areas and edges get resized.
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            unsigned char* pixel = &row[std::size_t(x) * 3];
+            bool is_dark = ((x / 256) + (y / 256)) % 2 == 0;
+
+            pixel[0] = static_cast<unsigned char>((x + y) * 255ull / (std::size_t(width) + height));
+            pixel[1] = static_cast<unsigned char>(y * 255ull / height);
+            pixel[2] = is_dark ? 32 : 224;
+        }
+
+        if (!writer.write_rows(row.data(), row.size(), 1))
+        {
+            std::remove(path.c_str());
+            return false;
+        }
+    }
+
+    if (!writer.finish())
+    {
+        std::remove(path.c_str());
+        return false;
+    }
+
+    return true;
+}
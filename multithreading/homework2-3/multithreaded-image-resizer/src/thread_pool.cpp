@@ -0,0 +1,104 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+#include "include/resizer_stats.h"
+#include "include/thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned int threads_number) :
+    pending_tasks_(0),
+    stop_(false)
+{
+    if (threads_number == 0)
+    {
+        threads_number = 1;
+    }
+
+    workers_.reserve(threads_number);
+
+    for (unsigned int i = 0; i < threads_number; ++i)
+    {
+        workers_.push_back(std::thread(&ThreadPool::worker_loop, this));
+    }
+
+    get_resizer_stats().add_workers(threads_number);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    task_available_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+
+    get_resizer_stats().add_workers(-static_cast<int>(workers_.size()));
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(std::move(task));
+        ++pending_tasks_;
+    }
+
+    get_resizer_stats().add_queue_depth(StatsQueue::pool_tasks, 1);
+
+    task_available_.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    tasks_finished_.wait(lock, [this] { return pending_tasks_ == 0; });
+}
+
+void ThreadPool::worker_loop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_available_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+
+            if (tasks_.empty())
+            {
+                return;  // Stopped and nothing left to do.
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+
+        ResizerStats& stats = get_resizer_stats();
+        stats.add_queue_depth(StatsQueue::pool_tasks, -1);
+
+        std::chrono::steady_clock::time_point task_start = std::chrono::steady_clock::now();
+
+        task();
+
+        stats.add_busy_time(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - task_start).count());
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if (--pending_tasks_ == 0)
+            {
+                tasks_finished_.notify_all();
+            }
+        }
+    }
+}